@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: Apache-2.0
+"""
+Generate the lookup tables of the table driven CRC-32 (CRC-32/ISO-HDLC,
+reflected polynomial 0xEDB88320) used by ram_retention_crc.c.
+
+Table k holds the CRC of byte n followed by k zero bytes, which is what
+the slicing-by-4/8 algorithms need.  A single table is the classic
+byte-wise algorithm.
+"""
+
+import argparse
+
+POLYNOMIAL = 0xEDB88320
+
+
+def crc32_tables(slices):
+    tables = [[0] * 256 for _ in range(slices)]
+
+    for n in range(256):
+        crc = n
+        for _ in range(8):
+            crc = (crc >> 1) ^ (POLYNOMIAL if crc & 1 else 0)
+        tables[0][n] = crc
+
+    for k in range(1, slices):
+        for n in range(256):
+            prev = tables[k - 1][n]
+            tables[k][n] = (prev >> 8) ^ tables[0][prev & 0xFF]
+
+    return tables
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--slices", type=int, choices=(1, 4, 8), required=True,
+                        help="number of tables to generate")
+    parser.add_argument("--output", required=True, help="generated header file")
+    args = parser.parse_args()
+
+    tables = crc32_tables(args.slices)
+
+    lines = [
+        "/* Generated by scripts/gen_crc32_table.py, do not edit. */",
+        "",
+        "#ifndef RAM_RETENTION_CRC32_TABLE_H",
+        "#define RAM_RETENTION_CRC32_TABLE_H",
+        "",
+        f"#define RAM_RETENTION_CRC32_TABLE_SLICES {args.slices}",
+        "",
+        "static const uint32_t ram_retention_crc32_table[RAM_RETENTION_CRC32_TABLE_SLICES][256] = {",
+    ]
+    for table in tables:
+        lines.append("\t{")
+        for i in range(0, 256, 8):
+            row = ", ".join(f"0x{value:08x}" for value in table[i:i + 8])
+            lines.append(f"\t\t{row},")
+        lines.append("\t},")
+    lines += [
+        "};",
+        "",
+        "#endif /* RAM_RETENTION_CRC32_TABLE_H */",
+        "",
+    ]
+
+    with open(args.output, "w", encoding="utf-8") as out:
+        out.write("\n".join(lines))
+
+
+if __name__ == "__main__":
+    main()
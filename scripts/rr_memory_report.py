@@ -0,0 +1,278 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: Apache-2.0
+"""
+Report the ram retention objects of a linked image and the RAM sections
+the boot pass retains for them.
+
+Every object of the ".ram_retained" section (see ram_retention_noinit.ld)
+is listed with its address, size, RAM block and section.  Objects that are
+registered with RR_Init_Var_Ram_Retention() have a descriptor, which gives
+the payload (bytes covered by the integrity check, without the layout
+header) and the overhead (crc variable, parity word, layout header and
+padding of the type).  Gaps between objects are alignment padding of the
+linker.
+
+The block/section column of an object is informational only.  Retention
+masks are computed from the bounds of the whole section,
+[__ram_retained_start, __ram_retained_end), the same range the boot pass
+retains, so padding and objects without a symbol are covered too.  The
+build fails when the number of retained sections is larger than the
+section budget.
+"""
+
+import argparse
+import sys
+
+from elftools.elf.elffile import ELFFile
+from elftools.elf.sections import SymbolTableSection
+
+# RAM geometry of each backend, same values as ram_retention_hal.h:
+# small section size, small sections per block, small blocks,
+# large section size, large sections, position of retention bit 0.
+BACKENDS = {
+    "power":   (4096, 2, 8, 32768, 16, 16),
+    "vmc":     (4096, 16, 8, 0, 0, 16),
+    "memconf": (32768, 8, 1, 0, 0, 0),
+    "none":    (None, 1, 1, 0, 0, 0),
+}
+
+# enum ramRetIntegrity
+INTEGRITIES = ["crc32", "crc16", "fletcher32", "none", "inverted", "ab", "ring", "ecc"]
+
+# Types whose crc_offset isn't the size of the checked payload
+UNSPLIT_INTEGRITIES = ("ab", "ring")
+
+# Members of struct ramRetDescriptor, in pointer sized words. layout is the
+# uint32_t after the bool lazy in word DESC_LAZY.
+DESC_ADDR = 0
+DESC_SIZE = 1
+DESC_CRC_OFFSET = 2
+DESC_LAZY = 6
+
+DESC_PREFIX = "_rr_desc_"
+
+
+class Geometry:
+    def __init__(self, backend, sram_begin, sram_size):
+        small, per_block, blocks, large, large_count, pos = BACKENDS[backend]
+
+        self.sram_begin = sram_begin
+        self.sram_size = sram_size
+        self.small = small if small is not None else sram_size
+        self.per_block = per_block
+        self.blocks = blocks
+        self.large = large
+        self.large_count = large_count
+        self.pos = pos
+        self.small_span = self.small * per_block * blocks
+
+    @property
+    def block_count(self):
+        return self.blocks + (1 if self.large_count else 0)
+
+    def section_of(self, addr):
+        """(block, section) of an address inside SRAM"""
+        offset = addr - self.sram_begin
+
+        if offset < self.small_span:
+            return offset // (self.small * self.per_block), (offset // self.small) % self.per_block
+
+        return self.blocks, (offset - self.small_span) // self.large
+
+    def sections_of(self, addr, size):
+        """Every (block, section) covered by the range"""
+        sections = []
+        block, section = self.section_of(addr)
+        last = self.section_of(addr + size - 1)
+
+        while True:
+            sections.append((block, section))
+            if (block, section) == last:
+                return sections
+            section += 1
+            if block < self.blocks and section == self.per_block:
+                block, section = block + 1, 0
+
+
+def symbols(elf):
+    for section in elf.iter_sections():
+        if isinstance(section, SymbolTableSection):
+            yield from section.iter_symbols()
+
+
+def read(elf, addr, size):
+    """Bytes at addr in the loaded image, None if addr isn't initialized data"""
+    for section in elf.iter_sections():
+        begin = section["sh_addr"]
+        if section["sh_type"] == "SHT_NOBITS" or begin == 0:
+            continue
+        if begin <= addr and addr + size <= begin + section["sh_size"]:
+            data = section.data()
+            return data[addr - begin:addr - begin + size]
+    return None
+
+
+def read_descriptor(elf, sym):
+    word = elf.elfclass // 8
+    order = "little" if elf.little_endian else "big"
+    data = read(elf, sym["st_value"], sym["st_size"])
+
+    layout = DESC_LAZY * word + 4
+
+    if data is None or len(data) < layout + 4 + 1:
+        return None
+
+    def field(index):
+        return int.from_bytes(data[index * word:(index + 1) * word], order)
+
+    # integrity is the last member, in the last word of the descriptor
+    integrity = data[len(data) - word]
+
+    return {
+        "addr": field(DESC_ADDR),
+        "size": field(DESC_SIZE),
+        "crc_offset": field(DESC_CRC_OFFSET),
+        "layout": int.from_bytes(data[layout:layout + 4], order),
+        "integrity": INTEGRITIES[integrity] if integrity < len(INTEGRITIES) else str(integrity),
+    }
+
+
+def collect(elf):
+    syms = list(symbols(elf))
+    bounds = {s.name: s["st_value"] for s in syms
+              if s.name in ("__ram_retained_start", "__ram_retained_end")}
+
+    if len(bounds) != 2:
+        sys.exit("error: __ram_retained_start/__ram_retained_end not found, "
+                 "ram_retention_noinit.ld isn't linked")
+
+    start, end = bounds["__ram_retained_start"], bounds["__ram_retained_end"]
+
+    descs = {}
+    for sym in syms:
+        if sym.name.startswith(DESC_PREFIX) and sym["st_info"]["type"] == "STT_OBJECT":
+            desc = read_descriptor(elf, sym)
+            if desc is not None:
+                descs[desc["addr"]] = desc
+
+    objects = {}
+    for sym in syms:
+        addr = sym["st_value"]
+        if (sym["st_info"]["type"] == "STT_OBJECT" and sym["st_size"] != 0
+                and start <= addr < end):
+            objects[addr] = {"name": sym.name, "addr": addr, "size": sym["st_size"],
+                             "desc": descs.get(addr)}
+
+    return start, end, [objects[addr] for addr in sorted(objects)]
+
+
+def split(obj):
+    """(payload, overhead) of a registered object, None if it can't be split"""
+    desc = obj["desc"]
+
+    if desc is None or desc["integrity"] in UNSPLIT_INTEGRITIES:
+        return None
+
+    header = 4 if desc["layout"] != 0 else 0
+    payload = desc["crc_offset"] - header
+
+    return payload, obj["size"] - payload
+
+
+def report(elf_name, geometry, start, end, objects, budget):
+    lines = [
+        f"Ram retention memory map of {elf_name}",
+        f".ram_retained 0x{start:08x} - 0x{end:08x}, {end - start} bytes",
+        "",
+        f"{'address':<10} {'size':>6} {'payload':>8} {'overhead':>8} {'gap':>5} "
+        f"{'block/sec':>9}  {'integrity':<10} name",
+    ]
+
+    masks = [0] * geometry.block_count
+    payload_total = overhead_total = gap_total = unsplit_total = 0
+    prev_end = start
+
+    for obj in objects:
+        addr, size = obj["addr"], obj["size"]
+        gap = max(addr - prev_end, 0)
+        prev_end = max(prev_end, addr + size)
+        gap_total += gap
+
+        parts = split(obj)
+        if parts is None:
+            payload = overhead = "-"
+            unsplit_total += size
+        else:
+            payload, overhead = parts
+            payload_total += payload
+            overhead_total += overhead
+
+        first_block, first_section = geometry.section_of(addr)
+        integrity = obj["desc"]["integrity"] if obj["desc"] is not None else "-"
+
+        lines.append(f"0x{addr:08x} {size:>6} {payload:>8} {overhead:>8} {gap:>5} "
+                     f"{f'{first_block}/{first_section}':>9}  {integrity:<10} {obj['name']}")
+
+    gap_total += max(end - prev_end, 0)
+
+    if end > start:
+        for block, section in geometry.sections_of(start, end - start):
+            masks[block] |= 1 << (geometry.pos + section)
+    retained = sum(bin(mask).count("1") for mask in masks)
+
+    lines += [
+        "",
+        f"{len(objects)} objects: payload {payload_total} bytes, overhead {overhead_total} bytes, "
+        f"not split {unsplit_total} bytes, alignment padding {gap_total} bytes",
+        "",
+        f"{'block':<6} mask",
+    ]
+    lines += [f"{block:<6} 0x{mask:08x}" for block, mask in enumerate(masks) if mask != 0]
+    lines += [
+        "",
+        f"retained sections: {retained}" + (f" (budget {budget})" if budget else ""),
+    ]
+
+    return lines, retained
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--elf", required=True, help="linked image, i.e. zephyr.elf")
+    parser.add_argument("--backend", choices=sorted(BACKENDS), required=True,
+                        help="retention control backend, gives the RAM geometry")
+    parser.add_argument("--sram-begin", type=lambda v: int(v, 0), required=True,
+                        help="address of SRAM")
+    parser.add_argument("--sram-size", type=lambda v: int(v, 0), required=True,
+                        help="size of SRAM")
+    parser.add_argument("--section-budget", type=int, default=0,
+                        help="largest number of retained sections, 0 for no limit")
+    parser.add_argument("--output", help="report file, the report is also printed")
+    args = parser.parse_args()
+
+    geometry = Geometry(args.backend, args.sram_begin, args.sram_size)
+
+    with open(args.elf, "rb") as f:
+        elf = ELFFile(f)
+        start, end, objects = collect(elf)
+
+    if start != end and not (args.sram_begin <= start
+                             and end <= args.sram_begin + args.sram_size):
+        sys.exit(f"error: .ram_retained 0x{start:08x} - 0x{end:08x} isn't within SRAM")
+
+    lines, retained = report(args.elf, geometry, start, end, objects, args.section_budget)
+    text = "\n".join(lines) + "\n"
+
+    if args.output:
+        with open(args.output, "w", encoding="utf-8") as out:
+            out.write(text)
+    print(text, end="")
+
+    if args.section_budget and retained > args.section_budget:
+        sys.exit(f"error: .ram_retained covers {retained} RAM sections, "
+                 f"CONFIG_APP_RETENTION_SECTION_BUDGET is {args.section_budget}")
+
+
+if __name__ == "__main__":
+    main()
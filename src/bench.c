@@ -0,0 +1,209 @@
+/**
+ * @author Batto1
+ * @brief  Benchmark application of nRF52 RAM retention utilities library, built instead of main.c with -DRR_BENCHMARK=ON.
+ *         Measures validate and update cycles of every integrity check algorithm over object sizes from 4 B to 16 KiB, and the
+ *         cost of a boot time validation pass over 1 to 256 variables, with the DWT cycle counter (the kernel cycle counter off target).
+ *         Results are printed as CSV lines starting with "RRBENCH," so they can be grepped from the console output and compared
+ *         between library versions. The CRC-32 implementation is selected at build time, build once for each CONFIG_APP_RETENTION_CRC32 choice
+ *         to compare them.
+ */
+
+
+#include <inttypes.h>
+#include <zephyr/kernel.h>
+
+#if defined(CONFIG_CPU_CORTEX_M_HAS_DWT)
+#include <zephyr/arch/arm/aarch32/cortex_m/cmsis.h>
+#endif
+
+#include "ram_retention_utils.h"
+
+
+/* Largest object of the size sweep */
+#define BENCH_MAX_SIZE		16384
+
+/* Room for the integrity check field after the largest object */
+#define BENCH_BUF_SIZE		(BENCH_MAX_SIZE + sizeof(uint32_t))
+
+/* Size of every variable of the count sweep, same as a RamRetInt64_t */
+#define BENCH_VAR_SIZE		8
+#define BENCH_VAR_STRIDE	(BENCH_VAR_SIZE + sizeof(uint32_t))
+
+/* Every measurement is repeated and the fewest cycles are reported, so
+ * that a cache or flash wait state miss of the first run doesn't count.
+ */
+#define BENCH_REPEAT		5
+
+static const size_t bench_sizes[] = { 4, 16, 64, 256, 1024, 4096, BENCH_MAX_SIZE };
+static const size_t bench_counts[] = { 1, 4, 16, 64, 256 };
+
+BUILD_ASSERT((256 * BENCH_VAR_STRIDE) <= BENCH_BUF_SIZE, "count sweep doesn't fit in the benchmark buffer");
+
+static const struct {
+	enum ramRetIntegrity	integrity;
+	const char *		name;
+} bench_integrities[] = {
+	{ RR_INTEGRITY_CRC32,		"crc32" },
+	{ RR_INTEGRITY_CRC16,		"crc16" },
+	{ RR_INTEGRITY_FLETCHER32,	"fletcher32" },
+};
+
+#if defined(CONFIG_APP_RETENTION_CRC32_SLICING_BY_8)
+#define BENCH_CRC32_BACKEND "slicing_by_8"
+#elif defined(CONFIG_APP_RETENTION_CRC32_SLICING_BY_4)
+#define BENCH_CRC32_BACKEND "slicing_by_4"
+#elif defined(CONFIG_APP_RETENTION_CRC32_TABLE)
+#define BENCH_CRC32_BACKEND "table"
+#else
+#define BENCH_CRC32_BACKEND "zephyr"
+#endif
+
+/* Objects are measured in a plain buffer, their content isn't retained. */
+static uint8_t bench_buf[BENCH_BUF_SIZE] __aligned(4);
+
+static volatile bool bench_sink;
+
+/* Number of benchmark runs since the last power-on, so that the boot pass of the library has a registered variable to validate. */
+RR_Init_Var_Ram_Retention(RamRetInt, g_bench_runs);
+
+
+
+#if defined(CONFIG_CPU_CORTEX_M_HAS_DWT)
+static inline void bench_timer_init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t bench_now(void)
+{
+	return DWT->CYCCNT;
+}
+
+static inline uint32_t bench_clock_hz(void)
+{
+	return SystemCoreClock;
+}
+#else
+/* Off target, i.e. native_sim with CONFIG_APP_RETENTION_BACKEND_POWER_EMUL, the hardware cycle counter of the kernel is used. */
+static inline void bench_timer_init(void) {}
+
+static inline uint32_t bench_now(void)
+{
+	return k_cycle_get_32();
+}
+
+static inline uint32_t bench_clock_hz(void)
+{
+	return (uint32_t)sys_clock_hw_cycles_per_sec();
+}
+#endif
+
+/* One CSV line.  Cycles per byte are printed in thousandths, so that no
+ * floating point printk support is needed.
+ */
+static void bench_report(const char *test, const char *integrity, size_t size, size_t count, uint32_t cycles)
+{
+	size_t bytes = size * count;
+	uint32_t mcpb = (bytes != 0U) ? (uint32_t)(((uint64_t)cycles * 1000U) / bytes) : 0U;
+
+	printk("RRBENCH,%s,%s,%s,%u,%u,%" PRIu32 ",%" PRIu32 "\n",
+	       test, integrity, BENCH_CRC32_BACKEND, (unsigned int)size, (unsigned int)count, cycles, mcpb);
+}
+
+static void bench_sizes_sweep(enum ramRetIntegrity integrity, const char *name)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(bench_sizes); i++) {
+		size_t size = bench_sizes[i];
+		uint32_t update_min = UINT32_MAX;
+		uint32_t validate_min = UINT32_MAX;
+
+		for (int r = 0; r < BENCH_REPEAT; r++) {
+			unsigned int key = irq_lock();
+			uint32_t start = bench_now();
+
+			ram_retained_update_integrity(integrity, bench_buf, size);
+
+			uint32_t mid = bench_now();
+
+			bench_sink = ram_retained_check_integrity(integrity, bench_buf, size);
+
+			uint32_t end = bench_now();
+
+			irq_unlock(key);
+
+			update_min = MIN(update_min, mid - start);
+			validate_min = MIN(validate_min, end - mid);
+		}
+
+		bench_report("update", name, size, 1, update_min);
+		bench_report("validate", name, size, 1, validate_min);
+	}
+}
+
+/* Same work as the boot time validation pass does for registered
+ * variables: validate every variable, collect the retention masks of
+ * their RAM sections and set the retention registers once.
+ */
+static void bench_boot_sweep(void)
+{
+	for (size_t c = 0; c < ARRAY_SIZE(bench_counts); c++) {
+		size_t count = bench_counts[c];
+		uint32_t boot_min = UINT32_MAX;
+
+		for (size_t i = 0; i < count; i++) {
+			ram_retained_update(&bench_buf[i * BENCH_VAR_STRIDE], BENCH_VAR_SIZE);
+		}
+
+		for (int r = 0; r < BENCH_REPEAT; r++) {
+			uint32_t masks[RR_RAM_BLOCK_COUNT] = {0};
+			unsigned int key = irq_lock();
+			uint32_t start = bench_now();
+
+			for (size_t i = 0; i < count; i++) {
+				void *var = &bench_buf[i * BENCH_VAR_STRIDE];
+
+				bench_sink = ram_retained_check_integrity(RR_INTEGRITY_CRC32, var, BENCH_VAR_SIZE);
+				(void)ram_retain_masks_add(masks, var, BENCH_VAR_STRIDE);
+			}
+			ram_retain_masks_apply(masks, true);
+
+			uint32_t end = bench_now();
+
+			irq_unlock(key);
+
+			boot_min = MIN(boot_min, end - start);
+		}
+
+		bench_report("boot", "crc32", BENCH_VAR_SIZE, count, boot_min);
+	}
+}
+
+void main(void)
+{
+	bench_timer_init();
+
+	g_bench_runs.rr_var++;
+	RR_Var_Ram_Ret_Defer(RamRetInt, g_bench_runs);
+
+	printk("RRBENCH,board,%s,%" PRIu32 ",%d\n", CONFIG_BOARD, bench_clock_hz(), g_bench_runs.rr_var);
+	printk("RRBENCH,test,integrity,crc32_backend,size,count,cycles,mcycles_per_byte\n");
+
+	for (size_t i = 0; i < ARRAY_SIZE(bench_integrities); i++) {
+		bench_sizes_sweep(bench_integrities[i].integrity, bench_integrities[i].name);
+	}
+
+	bench_boot_sweep();
+
+#if defined(CONFIG_APP_RETENTION_STATS)
+	/* Boot pass of the library itself, over the variables registered by the application. */
+	const struct ramRetBootStats *boot = ram_retained_boot_stats();
+
+	bench_report("boot_pass", "registered", 0, 0, boot->pass_cycles);
+	bench_report("boot_retain", "registered", 0, 0, boot->retain_cycles);
+#endif
+
+	printk("RRBENCH,done\n");
+
+	while(1);
+}
@@ -36,7 +36,7 @@ void main(void)
 {
 	for(int i = 0; i < 5; i++){
 		(void)atomic_inc(&g_cnt.rr_var); // increment RAM retained atomic variable.
-		RR_Var_Ram_Ret(RamRetAtomic, &g_cnt); // retain the variable after modifying it, otherwise changes won't be retained.
+		RR_Var_Ram_Ret_Defer(RamRetAtomic, g_cnt); // retain the variable after modifying it, otherwise changes won't be retained. Only marks it dirty if CONFIG_APP_RETENTION_DEFERRED_COMMIT=y.
 
 		k_busy_wait(100000); // wait 100msec.		
 	}
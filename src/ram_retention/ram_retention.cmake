@@ -0,0 +1,100 @@
+# SPDX-License-Identifier: Apache-2.0
+#
+# Sources, linker snippets and build steps of the ram retention library, included by the CMakeLists.txt of an application
+# after find_package(Zephyr), i.e. the sample in the root of the repository and the tests in tests/.
+
+set(RR_ROOT_DIR ${CMAKE_CURRENT_LIST_DIR}/../..)
+
+target_include_directories(app PUBLIC   ${RR_ROOT_DIR}/src/)
+target_include_directories(app PUBLIC   ${RR_ROOT_DIR}/src/ram_retention/)
+target_sources            (app PRIVATE  ${RR_ROOT_DIR}/src/ram_retention/ram_retention_utils.c)
+target_sources            (app PRIVATE  ${RR_ROOT_DIR}/src/ram_retention/ram_retention_crc.c)
+target_sources_ifdef      (CONFIG_APP_RETENTION_DEFERRED_COMMIT app PRIVATE ${RR_ROOT_DIR}/src/ram_retention/ram_retention_deferred.c)
+target_sources_ifdef      (CONFIG_APP_RETENTION_ARENA app PRIVATE ${RR_ROOT_DIR}/src/ram_retention/ram_retention_arena.c)
+target_sources_ifdef      (CONFIG_APP_RETENTION_SHELL app PRIVATE ${RR_ROOT_DIR}/src/ram_retention/ram_retention_shell.c)
+target_sources_ifdef      (CONFIG_APP_RETENTION_BACKEND_POWER_EMUL app PRIVATE ${RR_ROOT_DIR}/src/ram_retention/ram_retention_power_emul.c)
+target_sources_ifdef      (CONFIG_APP_RETENTION_SHARED app PRIVATE ${RR_ROOT_DIR}/src/ram_retention/ram_retention_shared.c)
+target_sources_ifdef      (CONFIG_APP_RETENTION_CRASH_RECORD app PRIVATE ${RR_ROOT_DIR}/src/ram_retention/ram_retention_crash.c)
+target_sources_ifdef      (CONFIG_APP_RETENTION_SPILL app PRIVATE ${RR_ROOT_DIR}/src/ram_retention/ram_retention_spill.c)
+target_sources_ifdef      (CONFIG_APP_RETENTION_DUMP app PRIVATE ${RR_ROOT_DIR}/src/ram_retention/ram_retention_dump.c)
+# arch_is_in_nested_exception() of the crash record is declared by the private kernel headers
+if(CONFIG_APP_RETENTION_CRASH_RECORD)
+  target_include_directories(app PRIVATE ${ZEPHYR_BASE}/kernel/include ${ZEPHYR_BASE}/arch/${ARCH}/include)
+endif()
+
+# Output section of the ram retention variables at the start of RAM, before .data, .bss and .noinit.
+zephyr_linker_sources(RAM_SECTIONS ${RR_ROOT_DIR}/src/ram_retention/ram_retention_noinit.ld)
+zephyr_linker_sources(SECTIONS     ${RR_ROOT_DIR}/src/ram_retention/ram_retention_descriptors.ld)
+# Link time retention masks are computed for the nRF52 layout only, other backends compute them in the boot pass.
+if(CONFIG_APP_RETENTION_BACKEND_POWER)
+  zephyr_linker_sources(SECTIONS ${RR_ROOT_DIR}/src/ram_retention/ram_retention_masks.ld)
+endif()
+
+# Flush points of the deferred commit mode wrap the Zephyr functions at link time.
+if(CONFIG_APP_RETENTION_DEFERRED_FLUSH_ON_REBOOT)
+  zephyr_ld_options(-Wl,--wrap=sys_reboot)
+endif()
+if(CONFIG_APP_RETENTION_DEFERRED_FLUSH_ON_SOFT_OFF AND CONFIG_POWEROFF)
+  zephyr_ld_options(-Wl,--wrap=sys_poweroff)
+endif()
+
+# Lookup tables of the table driven CRC-32 implementations are generated at build time.
+if(CONFIG_APP_RETENTION_CRC32_SLICING_BY_8)
+  set(RR_CRC32_TABLE_SLICES 8)
+elseif(CONFIG_APP_RETENTION_CRC32_SLICING_BY_4)
+  set(RR_CRC32_TABLE_SLICES 4)
+elseif(CONFIG_APP_RETENTION_CRC32_TABLE)
+  set(RR_CRC32_TABLE_SLICES 1)
+endif()
+
+if(DEFINED RR_CRC32_TABLE_SLICES)
+  set(RR_GENERATED_DIR ${CMAKE_CURRENT_BINARY_DIR}/ram_retention/generated)
+  set(RR_CRC32_TABLE_HEADER ${RR_GENERATED_DIR}/ram_retention_crc32_table.h)
+
+  add_custom_command(
+    OUTPUT  ${RR_CRC32_TABLE_HEADER}
+    COMMAND ${CMAKE_COMMAND} -E make_directory ${RR_GENERATED_DIR}
+    COMMAND ${PYTHON_EXECUTABLE} ${RR_ROOT_DIR}/scripts/gen_crc32_table.py
+            --slices ${RR_CRC32_TABLE_SLICES} --output ${RR_CRC32_TABLE_HEADER}
+    DEPENDS ${RR_ROOT_DIR}/scripts/gen_crc32_table.py
+  )
+  add_custom_target(ram_retention_crc32_table DEPENDS ${RR_CRC32_TABLE_HEADER})
+  add_dependencies(app ram_retention_crc32_table)
+
+  target_include_directories(app PRIVATE ${RR_GENERATED_DIR})
+endif()
+
+# Retained memory map of the linked image, the build fails if it covers more sections than CONFIG_APP_RETENTION_SECTION_BUDGET.
+if(CONFIG_APP_RETENTION_MEMORY_REPORT)
+  if(CONFIG_APP_RETENTION_BACKEND_POWER)
+    set(RR_REPORT_BACKEND power)
+  elseif(CONFIG_APP_RETENTION_BACKEND_VMC)
+    set(RR_REPORT_BACKEND vmc)
+  elseif(CONFIG_APP_RETENTION_BACKEND_MEMCONF)
+    set(RR_REPORT_BACKEND memconf)
+  else()
+    set(RR_REPORT_BACKEND none)
+  endif()
+
+  # Same SRAM node as ram_retention_hal.h
+  if(RR_REPORT_BACKEND STREQUAL none)
+    dt_chosen(RR_SRAM_NODE PROPERTY "zephyr,sram")
+  else()
+    dt_nodelabel(RR_SRAM_NODE NODELABEL sram0)
+  endif()
+  dt_reg_addr(RR_SRAM_BEGIN PATH ${RR_SRAM_NODE})
+  dt_reg_size(RR_SRAM_SIZE PATH ${RR_SRAM_NODE})
+
+  set(RR_REPORT ${CMAKE_CURRENT_BINARY_DIR}/ram_retention_report.txt)
+
+  # The ELF is linked by the zephyr_final target, app is only a library of it.
+  set_property(GLOBAL APPEND PROPERTY extra_post_build_commands
+    COMMAND ${PYTHON_EXECUTABLE} ${RR_ROOT_DIR}/scripts/rr_memory_report.py
+            --elf ${ZEPHYR_BINARY_DIR}/${KERNEL_ELF_NAME}
+            --backend ${RR_REPORT_BACKEND}
+            --sram-begin ${RR_SRAM_BEGIN} --sram-size ${RR_SRAM_SIZE}
+            --section-budget ${CONFIG_APP_RETENTION_SECTION_BUDGET}
+            --output ${RR_REPORT}
+  )
+  set_property(GLOBAL APPEND PROPERTY extra_post_build_byproducts ${RR_REPORT})
+endif()
@@ -0,0 +1,276 @@
+/**
+ * @author Batto1
+ * @brief  Retained arena (CONFIG_APP_RETENTION_ARENA), a bump allocator and a pool of fixed size blocks in one retained region.
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/logging/log.h>
+
+#include "ram_retention_utils.h"
+#include "ram_retention_crc.h"
+#include "ram_retention_arena.h"
+
+
+LOG_MODULE_DECLARE(ram_retention_utils, CONFIG_LOG_DEFAULT_LEVEL);
+
+
+/* Alignment of the data of every allocation */
+#define RECORD_ALIGN 8
+
+/* Region is aligned to a small RAM section (4 KiB), so that it spans
+ * as few retention controlled sections as its size allows.
+ */
+#define ARENA_ALIGN 4096
+
+/* Arena header is valid only with this magic, "RRAR" */
+#define ARENA_MAGIC 0x52524152
+
+#define POOL_BLOCK_SIZE  CONFIG_APP_RETENTION_ARENA_POOL_BLOCK_SIZE
+#define POOL_BLOCK_COUNT CONFIG_APP_RETENTION_ARENA_POOL_BLOCK_COUNT
+
+BUILD_ASSERT((POOL_BLOCK_SIZE % RECORD_ALIGN) == 0, "pool block size must be a multiple of 8");
+
+/* Header of every allocation, data follows it.  The header has its own
+ * CRC so that the records can be walked without checking the data, the
+ * data is checked only when the allocation is looked up.
+ */
+struct ramRetArenaRecord{
+	uint32_t	key;			// key of the allocation, RR_ARENA_KEY_FREE for a free pool block
+	uint32_t	size;			// size of the data
+	uint32_t	hdr_crc;		// CRC-32 of key and size
+	uint32_t	data_crc;		// CRC-32 of the data
+};
+
+BUILD_ASSERT((sizeof(struct ramRetArenaRecord) % RECORD_ALIGN) == 0, "record header breaks data alignment");
+
+/* Header of the bump allocated part */
+struct ramRetArenaHeader{
+	uint32_t	magic;			// ARENA_MAGIC
+	uint32_t	used;			// bytes allocated from the bump allocated part
+	uint32_t	crc;			// CRC-32 of magic and used
+	uint32_t	reserved;
+};
+
+/* Pool block, a record with space for POOL_BLOCK_SIZE bytes of data */
+struct ramRetPoolBlock{
+	struct ramRetArenaRecord	rec;
+	uint8_t				data[POOL_BLOCK_SIZE];
+};
+
+static struct {
+	struct ramRetArenaHeader	hdr;
+	struct ramRetPoolBlock		pool[POOL_BLOCK_COUNT];
+	uint8_t				bump[CONFIG_APP_RETENTION_ARENA_SIZE] __aligned(RECORD_ALIGN);
+} rr_arena __attribute__((__section__(".ram_retained_tail.rr_arena"))) __aligned(ARENA_ALIGN);
+
+
+
+static uint32_t arena_record_hdr_crc(const struct ramRetArenaRecord *rec)
+{
+	return ram_retention_crc32((const uint8_t *)rec, offsetof(struct ramRetArenaRecord, hdr_crc));
+}
+
+static bool arena_record_hdr_check(const struct ramRetArenaRecord *rec)
+{
+	return (arena_record_hdr_crc(rec) == rec->hdr_crc);
+}
+
+static void arena_record_commit(struct ramRetArenaRecord *rec)
+{
+	rec->data_crc = ram_retention_crc32((const uint8_t *)(rec + 1), rec->size);
+}
+
+/* Write a new record header with zeroed data. */
+static void arena_record_init(struct ramRetArenaRecord *rec, uint32_t key, size_t size)
+{
+	rec->key = key;
+	rec->size = (uint32_t)size;
+	rec->hdr_crc = arena_record_hdr_crc(rec);
+
+	memset(rec + 1, 0, size);
+	arena_record_commit(rec);
+}
+
+/* First lookup of an existing allocation, invalid data is zeroed. */
+static void *arena_record_restore(struct ramRetArenaRecord *rec, bool *a_p_restored)
+{
+	bool restored = (ram_retention_crc32((const uint8_t *)(rec + 1), rec->size) == rec->data_crc);
+
+	if (!restored) {
+		LOG_WRN("Ram ret arena allocation <%" PRIu32 "> isn't valid, zeroed", rec->key);
+		memset(rec + 1, 0, rec->size);
+		arena_record_commit(rec);
+	}
+
+	if (a_p_restored != NULL) {
+		*a_p_restored = restored;
+	}
+
+	return rec + 1;
+}
+
+static void arena_set_used(uint32_t used)
+{
+	rr_arena.hdr.magic = ARENA_MAGIC;
+	rr_arena.hdr.used = used;
+	rr_arena.hdr.crc = ram_retention_crc32((const uint8_t *)&rr_arena.hdr, offsetof(struct ramRetArenaHeader, crc));
+}
+
+static uint32_t arena_get_used(void)
+{
+	const struct ramRetArenaHeader *hdr = &rr_arena.hdr;
+
+	if ((hdr->magic != ARENA_MAGIC) || (hdr->used > sizeof(rr_arena.bump)) ||
+	    (ram_retention_crc32((const uint8_t *)hdr, offsetof(struct ramRetArenaHeader, crc)) != hdr->crc)) {
+		arena_set_used(0);
+	}
+
+	return rr_arena.hdr.used;
+}
+
+void *ram_retained_arena_alloc(uint32_t a_key, size_t a_size, bool *a_p_restored)
+{
+	__ASSERT_NO_MSG(a_key != RR_ARENA_KEY_FREE);
+
+	void *ptr = NULL;
+	unsigned int key = irq_lock();
+	uint32_t used = arena_get_used();
+	uint32_t offset = 0;
+
+	while (offset < used) {
+		struct ramRetArenaRecord *rec = (struct ramRetArenaRecord *)&rr_arena.bump[offset];
+		uint32_t left = used - offset;
+
+		/* A torn record can only be the last one, it is dropped. */
+		if ((left < sizeof(*rec)) || !arena_record_hdr_check(rec) ||
+		    (ROUND_UP(rec->size, RECORD_ALIGN) > (left - sizeof(*rec)))) {
+			LOG_WRN("Ram ret arena truncated at %" PRIu32 " bytes", offset);
+			used = offset;
+			arena_set_used(used);
+			break;
+		}
+
+		if (rec->key == a_key) {
+			if (rec->size == a_size) {
+				ptr = arena_record_restore(rec, a_p_restored);
+			} else {
+				LOG_ERR("Ram ret arena allocation <%" PRIu32 "> has another size", a_key);
+			}
+			goto out;
+		}
+
+		offset += sizeof(*rec) + ROUND_UP(rec->size, RECORD_ALIGN);
+	}
+
+	size_t needed = sizeof(struct ramRetArenaRecord) + ROUND_UP(a_size, RECORD_ALIGN);
+
+	if (needed > (sizeof(rr_arena.bump) - used)) {
+		LOG_ERR("Ram ret arena is full");
+		goto out;
+	}
+
+	struct ramRetArenaRecord *rec = (struct ramRetArenaRecord *)&rr_arena.bump[used];
+
+	/* Record is complete before it is published by the header. */
+	arena_record_init(rec, a_key, a_size);
+	arena_set_used(used + needed);
+
+	if (a_p_restored != NULL) {
+		*a_p_restored = false;
+	}
+	ptr = rec + 1;
+
+out:
+	irq_unlock(key);
+	return ptr;
+}
+
+void *ram_retained_pool_alloc(uint32_t a_key, size_t a_size, bool *a_p_restored)
+{
+	__ASSERT_NO_MSG(a_key != RR_ARENA_KEY_FREE);
+
+	if (a_size > POOL_BLOCK_SIZE) {
+		return NULL;
+	}
+
+	void *ptr = NULL;
+	struct ramRetArenaRecord *free_rec = NULL;
+	unsigned int key = irq_lock();
+
+	for (size_t i = 0; i < POOL_BLOCK_COUNT; i++) {
+		struct ramRetArenaRecord *rec = &rr_arena.pool[i].rec;
+
+		/* A block with an invalid header is free. */
+		if (!arena_record_hdr_check(rec) || (rec->key == RR_ARENA_KEY_FREE) ||
+		    (rec->size > POOL_BLOCK_SIZE)) {
+			if (free_rec == NULL) {
+				free_rec = rec;
+			}
+			continue;
+		}
+
+		if (rec->key == a_key) {
+			if (rec->size == a_size) {
+				ptr = arena_record_restore(rec, a_p_restored);
+			} else {
+				LOG_ERR("Ram ret pool block <%" PRIu32 "> has another size", a_key);
+			}
+			goto out;
+		}
+	}
+
+	if (free_rec == NULL) {
+		LOG_ERR("Ram ret pool is full");
+		goto out;
+	}
+
+	arena_record_init(free_rec, a_key, a_size);
+
+	if (a_p_restored != NULL) {
+		*a_p_restored = false;
+	}
+	ptr = free_rec + 1;
+
+out:
+	irq_unlock(key);
+	return ptr;
+}
+
+void ram_retained_pool_free(void *a_ptr)
+{
+	struct ramRetArenaRecord *rec = (struct ramRetArenaRecord *)a_ptr - 1;
+
+	__ASSERT_NO_MSG(((uint8_t *)rec >= (uint8_t *)rr_arena.pool) &&
+			((uint8_t *)rec < (uint8_t *)rr_arena.pool + sizeof(rr_arena.pool)));
+
+	unsigned int key = irq_lock();
+
+	rec->key = RR_ARENA_KEY_FREE;
+	rec->size = 0;
+	rec->hdr_crc = arena_record_hdr_crc(rec);
+
+	irq_unlock(key);
+}
+
+void ram_retained_arena_commit(void *a_ptr)
+{
+	arena_record_commit((struct ramRetArenaRecord *)a_ptr - 1);
+}
+
+void ram_retained_arena_reset(void)
+{
+	unsigned int key = irq_lock();
+
+	for (size_t i = 0; i < POOL_BLOCK_COUNT; i++) {
+		struct ramRetArenaRecord *rec = &rr_arena.pool[i].rec;
+
+		rec->key = RR_ARENA_KEY_FREE;
+		rec->size = 0;
+		rec->hdr_crc = arena_record_hdr_crc(rec);
+	}
+	arena_set_used(0);
+
+	irq_unlock(key);
+}
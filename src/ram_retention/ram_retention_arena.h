@@ -0,0 +1,69 @@
+/**
+ * @author Batto1
+ * @brief  Retained arena (CONFIG_APP_RETENTION_ARENA) for ram retention memory that is only known at runtime.
+ *         Allocations are identified by a key and found again after a reset. Every allocation is validated when it is
+ *         first looked up, not at boot.
+ */
+
+#ifndef RAM_RETENTION_ARENA_H
+#define RAM_RETENTION_ARENA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+
+/**
+ * @brief Reserved key, can't be used for allocations.
+*/
+#define RR_ARENA_KEY_FREE 0
+
+
+/**
+ * @brief Allocate retained memory from the bump allocated part of the arena, or find the allocation made with the same key before the reset.
+ * @note  Allocations live until ram_retained_arena_reset(). Calling it again with the same key returns the same memory.
+ * @note  A new allocation, or one whose data isn't valid anymore, is zeroed.
+ * @param [in]  a_key        key of the allocation, anything except RR_ARENA_KEY_FREE, i.e. a module id.
+ * @param [in]  a_size       size of the allocation, must be the same as before the reset.
+ * @param [out] a_p_restored set to true if the data is retained from before the reset, false if it is zeroed. Can be NULL.
+ * @return pointer to the allocation, 8 byte aligned. NULL if the arena is full or the key is used with another size.
+*/
+void *ram_retained_arena_alloc(uint32_t a_key, size_t a_size, bool *a_p_restored);
+
+/**
+ * @brief Allocate a block from the retained pool, or find the block allocated with the same key before the reset.
+ * @note  Same as ram_retained_arena_alloc() but the block can be freed with ram_retained_pool_free().
+ * @param [in]  a_key        key of the block, anything except RR_ARENA_KEY_FREE.
+ * @param [in]  a_size       size of the allocation, at most CONFIG_APP_RETENTION_ARENA_POOL_BLOCK_SIZE.
+ * @param [out] a_p_restored set to true if the data is retained from before the reset, false if it is zeroed. Can be NULL.
+ * @return pointer to the block, 8 byte aligned. NULL if all blocks are used or a_size doesn't fit.
+*/
+void *ram_retained_pool_alloc(uint32_t a_key, size_t a_size, bool *a_p_restored);
+
+/**
+ * @brief Free a block allocated with ram_retained_pool_alloc().
+ * @param [in] a_ptr pointer returned by ram_retained_pool_alloc()
+*/
+void ram_retained_pool_free(void *a_ptr);
+
+/**
+ * @brief Retain an allocation of the arena or the pool after modifying it, same as RR_Var_Ram_Ret() for ram retention variables.
+ * @param [in] a_ptr pointer returned by ram_retained_arena_alloc() or ram_retained_pool_alloc()
+*/
+void ram_retained_arena_commit(void *a_ptr);
+
+/**
+ * @brief Drop every allocation of the arena and the pool.
+*/
+void ram_retained_arena_reset(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RAM_RETENTION_ARENA_H */
@@ -0,0 +1,190 @@
+/**
+ * @author Batto1
+ * @brief  Retained crash record (CONFIG_APP_RETENTION_CRASH_RECORD), see ram_retention_crash.h.
+ *         Record is a registered Fletcher-32 checked variable, so it is validated by the boot pass like any other variable and a record
+ *         torn by a reset in the middle of the capture is zeroed. The fault path only copies words and computes one Fletcher-32 over a
+ *         record of fixed size, crc32_ieee() isn't used.
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/fatal.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/logging/log.h>
+
+#if defined(CONFIG_APP_RETENTION_CRASH_REBOOT)
+#include <zephyr/sys/reboot.h>
+#endif
+
+#if defined(CONFIG_ARMV7_M_ARMV8_M_MAINLINE)
+#include <zephyr/arch/arm/aarch32/cortex_m/cmsis.h>
+#endif
+
+#if defined(CONFIG_ARCH_HAS_NESTED_EXCEPTION_DETECTION)
+#include <kernel_arch_interface.h>
+#endif
+
+#include "ram_retention_utils.h"
+#include "ram_retention_hal.h"
+#include "ram_retention_crash.h"
+
+
+LOG_MODULE_DECLARE(ram_retention_utils, CONFIG_LOG_DEFAULT_LEVEL);
+
+
+RamRetTypeDeclareIntegrity(struct ramRetCrashRecord, RamRetCrashRecord, FLETCHER32);
+
+RR_Init_Var_Ram_Retention(RamRetCrashRecord, rr_crash_record);
+
+/* Breadcrumbs don't need to be retained, they are copied into the record by the fault path. */
+static uint32_t crumbs[CONFIG_APP_RETENTION_CRASH_BREADCRUMBS];
+static atomic_t crumb_head;
+
+static bool crash_reported;
+
+
+
+void ram_retained_crash_breadcrumb(uint32_t a_crumb)
+{
+	uint32_t idx = (uint32_t)atomic_inc(&crumb_head);
+
+	crumbs[idx % CONFIG_APP_RETENTION_CRASH_BREADCRUMBS] = a_crumb;
+}
+
+#if defined(CONFIG_ARM)
+/* Words above the exception stack frame, the copy stops at the end of SRAM. */
+static uint32_t crash_copy_stack(uint32_t *a_p_dst, uintptr_t a_sp)
+{
+	uintptr_t begin = a_sp + (RR_CRASH_REG_COUNT * sizeof(uint32_t));
+	uintptr_t end = RR_HAL_SRAM_BEGIN + RR_HAL_SRAM_SIZE;
+	uint32_t count = 0;
+
+	if ((a_sp < RR_HAL_SRAM_BEGIN) || (begin >= end) || ((a_sp & 0x3) != 0U)) {
+		return 0;
+	}
+
+	while ((count < CONFIG_APP_RETENTION_CRASH_STACK_WORDS) && (begin + sizeof(uint32_t) <= end)) {
+		a_p_dst[count++] = *(const uint32_t *)begin;
+		begin += sizeof(uint32_t);
+	}
+
+	return count;
+}
+#endif /* CONFIG_ARM */
+
+static uint32_t crash_copy_breadcrumbs(uint32_t *a_p_dst)
+{
+	uint32_t head = (uint32_t)atomic_get(&crumb_head);
+	uint32_t count = MIN(head, (uint32_t)CONFIG_APP_RETENTION_CRASH_BREADCRUMBS);
+
+	for (uint32_t i = 0; i < count; i++) {
+		a_p_dst[i] = crumbs[(head - count + i) % CONFIG_APP_RETENTION_CRASH_BREADCRUMBS];
+	}
+
+	return count;
+}
+
+void ram_retained_crash_capture(unsigned int a_reason, const z_arch_esf_t *a_esf)
+{
+	struct ramRetCrashRecord *rec = &rr_crash_record.rr_var;
+
+	/* Record holds no crash until it is complete, even if a torn record happens to pass its check. */
+	memset(rec, 0, sizeof(*rec));
+
+	rec->reason = a_reason;
+	rec->uptime_ms = k_uptime_get_32();
+	rec->thread = (uint32_t)(uintptr_t)k_current_get();
+
+#if defined(CONFIG_ARCH_HAS_NESTED_EXCEPTION_DETECTION)
+	/* k_is_in_isr() is always true in the fault handler, the exception frame tells whether an ISR was interrupted. */
+	if (a_esf != NULL) {
+		rec->in_isr = arch_is_in_nested_exception(a_esf) ? 1U : 0U;
+	}
+#endif
+
+#if defined(CONFIG_ARM)
+	if (a_esf != NULL) {
+		rec->sp = (uint32_t)(uintptr_t)a_esf;
+		rec->regs[RR_CRASH_REG_R0] = a_esf->basic.a1;
+		rec->regs[RR_CRASH_REG_R1] = a_esf->basic.a2;
+		rec->regs[RR_CRASH_REG_R2] = a_esf->basic.a3;
+		rec->regs[RR_CRASH_REG_R3] = a_esf->basic.a4;
+		rec->regs[RR_CRASH_REG_R12] = a_esf->basic.ip;
+		rec->regs[RR_CRASH_REG_LR] = a_esf->basic.lr;
+		rec->regs[RR_CRASH_REG_PC] = a_esf->basic.pc;
+		rec->regs[RR_CRASH_REG_XPSR] = a_esf->basic.xpsr;
+		rec->stack_words = crash_copy_stack(rec->stack, (uintptr_t)a_esf);
+	}
+#else
+	ARG_UNUSED(a_esf);
+#endif
+
+#if defined(CONFIG_ARMV7_M_ARMV8_M_MAINLINE)
+	rec->cfsr = SCB->CFSR;
+	rec->hfsr = SCB->HFSR;
+	rec->mmfar = SCB->MMFAR;
+	rec->bfar = SCB->BFAR;
+#endif
+
+	rec->breadcrumb_count = crash_copy_breadcrumbs(rec->breadcrumbs);
+	rec->magic = RR_CRASH_MAGIC_NEW;
+
+	RR_Var_Ram_Ret(RamRetCrashRecord, &rr_crash_record);
+}
+
+const struct ramRetCrashRecord *ram_retained_crash_last(void)
+{
+	return crash_reported ? &rr_crash_record.rr_var : NULL;
+}
+
+/* Runs after the boot pass, which zeroes the record if it isn't valid. */
+static int ram_retention_crash_init(const struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	struct ramRetCrashRecord *rec = &rr_crash_record.rr_var;
+
+	if (rec->magic != RR_CRASH_MAGIC_NEW) {
+		return 0;
+	}
+
+	crash_reported = true;
+	rec->magic = RR_CRASH_MAGIC_REPORTED;
+	RR_Var_Ram_Ret(RamRetCrashRecord, &rr_crash_record);
+
+	LOG_WRN("Fatal error %" PRIu32 " before the last reset, pc 0x%08" PRIx32 " lr 0x%08" PRIx32,
+		rec->reason, rec->regs[RR_CRASH_REG_PC], rec->regs[RR_CRASH_REG_LR]);
+
+	return 0;
+}
+
+SYS_INIT(ram_retention_crash_init, APPLICATION, 31);
+
+
+
+#if defined(CONFIG_APP_RETENTION_CRASH_HANDLER)
+
+/* Overrides the weak default handler, also takes over the flush of ram_retention_deferred.c. */
+void k_sys_fatal_error_handler(unsigned int reason, const z_arch_esf_t *esf)
+{
+	ram_retained_crash_capture(reason, esf);
+
+#if defined(CONFIG_APP_RETENTION_DEFERRED_FLUSH_ON_FATAL)
+	ram_retained_flush();
+#endif
+
+	LOG_PANIC();
+
+#if defined(CONFIG_APP_RETENTION_CRASH_REBOOT)
+	LOG_ERR("Rebooting system");
+	sys_reboot(SYS_REBOOT_WARM);
+#else
+	LOG_ERR("Halting system");
+	k_fatal_halt(reason);
+#endif
+	CODE_UNREACHABLE;
+}
+
+#endif /* CONFIG_APP_RETENTION_CRASH_HANDLER */
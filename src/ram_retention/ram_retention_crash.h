@@ -0,0 +1,96 @@
+/**
+ * @author Batto1
+ * @brief  Retained crash record (CONFIG_APP_RETENTION_CRASH_RECORD). k_sys_fatal_error_handler() copies the fault context, the top of the
+ *         faulting stack and the last breadcrumbs into a fixed layout record in the ".ram_retained" section and checks it with Fletcher-32,
+ *         in a bounded routine that doesn't allocate, log or wait. Record of the previous boot is validated before main() and read with
+ *         ram_retained_crash_last().
+ * @note   HardFault, MemManage, BusFault and UsageFault of Cortex-M reach k_sys_fatal_error_handler() through z_fatal_error(), so they are
+ *         recorded as well.
+ */
+
+#ifndef RAM_RETENTION_CRASH_H
+#define RAM_RETENTION_CRASH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <inttypes.h>
+#include <zephyr/fatal.h>
+
+
+/**
+ * @brief Registers of the exception stack frame, in the order they are stacked by Cortex-M.
+*/
+enum ramRetCrashReg{
+	RR_CRASH_REG_R0 = 0,
+	RR_CRASH_REG_R1,
+	RR_CRASH_REG_R2,
+	RR_CRASH_REG_R3,
+	RR_CRASH_REG_R12,
+	RR_CRASH_REG_LR,
+	RR_CRASH_REG_PC,
+	RR_CRASH_REG_XPSR,
+	RR_CRASH_REG_COUNT
+};
+
+/**
+ * @brief Crash record, layout doesn't depend on the architecture so that it can be decoded from a RAM dump.
+ * @note  Registers, fault status registers and in_isr are 0 where the architecture doesn't have them, or when no exception frame is given.
+*/
+struct ramRetCrashRecord{
+	uint32_t	reason;					// reason of k_sys_fatal_error_handler(), enum k_fatal_error_reason
+	uint32_t	uptime_ms;				// k_uptime_get_32() at the fault
+	uint32_t	thread;					// k_current_get() at the fault, the interrupted thread for a fault in an ISR
+	uint32_t	in_isr;					// 1 if the fault was taken while handling an interrupt, arch_is_in_nested_exception()
+	uint32_t	sp;					// stack pointer at the fault, address of the exception stack frame
+	uint32_t	regs[RR_CRASH_REG_COUNT];		// exception stack frame, enum ramRetCrashReg
+	uint32_t	cfsr;					// SCB->CFSR, Cortex-M Mainline only
+	uint32_t	hfsr;					// SCB->HFSR, Cortex-M Mainline only
+	uint32_t	mmfar;					// SCB->MMFAR, Cortex-M Mainline only
+	uint32_t	bfar;					// SCB->BFAR, Cortex-M Mainline only
+	uint32_t	stack_words;				// number of valid words in stack
+	uint32_t	stack[CONFIG_APP_RETENTION_CRASH_STACK_WORDS];	// words above the exception stack frame
+	uint32_t	breadcrumb_count;			// number of valid words in breadcrumbs
+	uint32_t	breadcrumbs[CONFIG_APP_RETENTION_CRASH_BREADCRUMBS];	// last breadcrumbs, oldest first
+	uint32_t	magic;					// RR_CRASH_MAGIC_* state of the record
+};
+
+/**
+ * @brief State of the record. Record holding any other value (i.e. a zeroed record after a power-on reset) holds no crash.
+*/
+#define RR_CRASH_MAGIC_NEW	0x43525348	// written by the fault path, not reported yet
+#define RR_CRASH_MAGIC_REPORTED	0x52505444	// reported by ram_retained_crash_last() at a previous boot
+
+
+/**
+ * @brief Leave a breadcrumb, i.e. an event id or an address, that is copied into the crash record if a fatal error happens later.
+ * @note  Lock-free and safe from ISRs. Breadcrumbs are kept in ordinary RAM, only the last CONFIG_APP_RETENTION_CRASH_BREADCRUMBS
+ *        of them are kept.
+ * @param [in] a_crumb value of the breadcrumb
+*/
+void ram_retained_crash_breadcrumb(uint32_t a_crumb);
+
+/**
+ * @brief Record the fault context. Called by k_sys_fatal_error_handler() of the library, only needed when the application has its own handler.
+ * @note  Bounded and ISR-safe, doesn't allocate, log or wait for anything. Stack is only read inside SRAM.
+ * @param [in] a_reason reason of the fatal error
+ * @param [in] a_esf    exception stack frame, can be NULL
+*/
+void ram_retained_crash_capture(unsigned int a_reason, const z_arch_esf_t *a_esf);
+
+/**
+ * @brief Crash record of the fatal error that caused the last reset.
+ * @note  Record is reported at one boot only, the boot after the crash, and its magic is RR_CRASH_MAGIC_REPORTED by then.
+ *        It stays in retained RAM until the next fatal error.
+ * @return pointer to the record, NULL if the last reset wasn't caused by a recorded fatal error.
+*/
+const struct ramRetCrashRecord *ram_retained_crash_last(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RAM_RETENTION_CRASH_H */
@@ -0,0 +1,208 @@
+/**
+ * @author Batto1
+ * @brief  Table driven CRC-32 implementations and Fletcher-32 for ram retention variables.
+ */
+
+#include <stddef.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
+
+#include "ram_retention_crc.h"
+
+#if !defined(CONFIG_APP_RETENTION_CRC32_ZEPHYR)
+#include "ram_retention_crc32_table.h"
+#endif
+
+
+
+#if defined(RAM_RETENTION_CRC32_TABLE_SLICES)
+
+#define T ram_retention_crc32_table
+
+/* Classic byte-wise table algorithm, also used for the unaligned head and
+ * the tail of the sliced algorithms.  Works on the inverted CRC.
+ */
+static inline uint32_t crc32_bytes(uint32_t crc, const uint8_t *data, size_t len)
+{
+	while (len-- > 0U) {
+		crc = T[0][(crc ^ *data++) & 0xFFU] ^ (crc >> 8);
+	}
+
+	return crc;
+}
+
+/* Number of bytes until data is word aligned, limited to len. */
+static inline size_t crc32_head_len(const uint8_t *data, size_t len)
+{
+	return MIN(len, (size_t)((sizeof(uint32_t) - ((uintptr_t)data & (sizeof(uint32_t) - 1U))) & (sizeof(uint32_t) - 1U)));
+}
+
+#endif /* RAM_RETENTION_CRC32_TABLE_SLICES */
+
+
+
+#if defined(CONFIG_APP_RETENTION_CRC32_SLICING_BY_4)
+
+BUILD_ASSERT(RAM_RETENTION_CRC32_TABLE_SLICES >= 4, "slicing-by-4 needs 4 tables");
+
+static uint32_t crc32_slicing_by_4(uint32_t crc, const uint8_t *data, size_t len)
+{
+	size_t head = crc32_head_len(data, len);
+
+	crc = crc32_bytes(crc, data, head);
+	data += head;
+	len -= head;
+
+	while (len >= 4U) {
+		crc ^= sys_le32_to_cpu(*(const uint32_t *)data);
+		crc = T[3][crc & 0xFFU] ^ T[2][(crc >> 8) & 0xFFU]
+		      ^ T[1][(crc >> 16) & 0xFFU] ^ T[0][crc >> 24];
+		data += 4;
+		len -= 4U;
+	}
+
+	return crc32_bytes(crc, data, len);
+}
+
+#endif
+
+#if defined(CONFIG_APP_RETENTION_CRC32_SLICING_BY_8)
+
+BUILD_ASSERT(RAM_RETENTION_CRC32_TABLE_SLICES >= 8, "slicing-by-8 needs 8 tables");
+
+static uint32_t crc32_slicing_by_8(uint32_t crc, const uint8_t *data, size_t len)
+{
+	size_t head = crc32_head_len(data, len);
+
+	crc = crc32_bytes(crc, data, head);
+	data += head;
+	len -= head;
+
+	while (len >= 8U) {
+		uint32_t one = sys_le32_to_cpu(*(const uint32_t *)data) ^ crc;
+		uint32_t two = sys_le32_to_cpu(*(const uint32_t *)(data + 4));
+
+		crc = T[7][one & 0xFFU] ^ T[6][(one >> 8) & 0xFFU]
+		      ^ T[5][(one >> 16) & 0xFFU] ^ T[4][one >> 24]
+		      ^ T[3][two & 0xFFU] ^ T[2][(two >> 8) & 0xFFU]
+		      ^ T[1][(two >> 16) & 0xFFU] ^ T[0][two >> 24];
+		data += 8;
+		len -= 8U;
+	}
+
+	return crc32_bytes(crc, data, len);
+}
+
+#endif
+
+
+
+uint32_t ram_retention_crc32_update(uint32_t crc, const uint8_t *data, size_t len)
+{
+#if defined(CONFIG_APP_RETENTION_CRC32_ZEPHYR)
+	return crc32_ieee_update(crc, data, len);
+#else
+	crc = ~crc;
+
+#if defined(CONFIG_APP_RETENTION_CRC32_SLICING_BY_8)
+	crc = crc32_slicing_by_8(crc, data, len);
+#elif defined(CONFIG_APP_RETENTION_CRC32_SLICING_BY_4)
+	crc = crc32_slicing_by_4(crc, data, len);
+#else
+	crc = crc32_bytes(crc, data, len);
+#endif
+
+	return ~crc;
+#endif
+}
+
+
+
+/* Reflected CRC-32/ISO-HDLC polynomial */
+#define CRC32_POLYNOMIAL 0xEDB88320U
+
+/* x^(2^k) modulo the CRC-32 polynomial, reflected, for k = 0..31 */
+static const uint32_t crc32_x2n_table[32] = {
+	0x40000000, 0x20000000, 0x08000000, 0x00800000,
+	0x00008000, 0xedb88320, 0xb1e6b092, 0xa06a2517,
+	0xed627dae, 0x88d14467, 0xd7bbfe6a, 0xec447f11,
+	0x8e7ea170, 0x6427800e, 0x4d47bae0, 0x09fe548f,
+	0x83852d0f, 0x30362f1a, 0x7b5a9cc3, 0x31fec169,
+	0x9fec022a, 0x6c8dedc4, 0x15d6874d, 0x5fde7a4e,
+	0xbad90e37, 0x2e4e5eef, 0x4eaba214, 0xa8a472c0,
+	0x429a969e, 0x148d302a, 0xc40ba6d0, 0xc4e22c3c,
+};
+
+/* a * b modulo the CRC-32 polynomial, reflected */
+static uint32_t crc32_multmodp(uint32_t a, uint32_t b)
+{
+	uint32_t m = BIT(31);
+	uint32_t p = 0;
+
+	while (a != 0U) {
+		if ((a & m) != 0U) {
+			p ^= b;
+			a ^= m;
+		}
+		m >>= 1;
+		b = ((b & 1U) != 0U) ? ((b >> 1) ^ CRC32_POLYNOMIAL) : (b >> 1);
+	}
+
+	return p;
+}
+
+uint32_t ram_retention_crc32_shift(uint32_t raw, size_t len)
+{
+	/* Appending a zero byte multiplies by x^8, so start from x^(2^3). */
+	unsigned int k = 3;
+
+	while ((len != 0U) && (raw != 0U)) {
+		if ((len & 1U) != 0U) {
+			raw = crc32_multmodp(crc32_x2n_table[k & 31U], raw);
+		}
+		len >>= 1;
+		k++;
+	}
+
+	return raw;
+}
+
+
+
+/* Largest number of 16-bit words that can be summed before sum2 may
+ * overflow 32 bits, so the modulo reduction is only done once per block.
+ */
+#define FLETCHER32_BLOCK_WORDS 359
+
+uint32_t ram_retention_fletcher32(const uint8_t *data, size_t len)
+{
+	uint32_t sum1 = 0xFFFFU;
+	uint32_t sum2 = 0xFFFFU;
+	size_t words = len / 2U;
+
+	while (words > 0U) {
+		size_t block = MIN(words, (size_t)FLETCHER32_BLOCK_WORDS);
+
+		words -= block;
+		do {
+			sum1 += (uint32_t)data[0] | ((uint32_t)data[1] << 8);
+			sum2 += sum1;
+			data += 2;
+		} while (--block > 0U);
+
+		sum1 = (sum1 & 0xFFFFU) + (sum1 >> 16);
+		sum2 = (sum2 & 0xFFFFU) + (sum2 >> 16);
+	}
+
+	if ((len & 1U) != 0U) {
+		sum1 += *data;
+		sum2 += sum1;
+	}
+
+	/* Second reduction step to reduce sums to 16 bits */
+	sum1 = (sum1 & 0xFFFFU) + (sum1 >> 16);
+	sum2 = (sum2 & 0xFFFFU) + (sum2 >> 16);
+
+	return (sum2 << 16) | sum1;
+}
@@ -0,0 +1,74 @@
+/**
+ * @author Batto1
+ * @brief  CRC-32 (CRC-32/ISO-HDLC) and the other checksums used for the integrity check of ram retention variables.
+ *         Implementation is selected with the CONFIG_APP_RETENTION_CRC32 Kconfig choice, every implementation gives the same result as Zephyr's crc32_ieee()
+ *         so retained data stays valid when the implementation is changed.
+ */
+
+#ifndef RAM_RETENTION_CRC_H
+#define RAM_RETENTION_CRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <inttypes.h>
+
+
+/**
+ * @brief Update a CRC-32 with more data. Same semantics as Zephyr's crc32_ieee_update().
+ * @param [in] crc  CRC-32 of the data before, 0 for the first call.
+ * @param [in] data pointer to the data
+ * @param [in] len  length of the data
+ * @return updated CRC-32
+*/
+uint32_t ram_retention_crc32_update(uint32_t crc, const uint8_t *data, size_t len);
+
+/**
+ * @brief CRC-32 of the data. Same semantics as Zephyr's crc32_ieee().
+ * @param [in] data pointer to the data
+ * @param [in] len  length of the data
+ * @return CRC-32
+*/
+static inline uint32_t ram_retention_crc32(const uint8_t *data, size_t len)
+{
+	return ram_retention_crc32_update(0, data, len);
+}
+
+/**
+ * @brief Linear part of the CRC-32 (no initial value, no final xor), as used for patching a CRC-32 when only part of the data changed.
+ * @param [in] raw  linear CRC-32 of the data before, 0 for the first call.
+ * @param [in] data pointer to the data
+ * @param [in] len  length of the data
+ * @return updated linear CRC-32
+*/
+static inline uint32_t ram_retention_crc32_raw(uint32_t raw, const uint8_t *data, size_t len)
+{
+	return ~ram_retention_crc32_update(~raw, data, len);
+}
+
+/**
+ * @brief Advance a linear CRC-32 over len zero bytes, in time that depends on log2(len) instead of len.
+ * @note  CRC(a ^ b) == CRC(a) ^ CRC(b) for the linear part, so the CRC-32 of a message changed at one place can be patched with
+ *        ram_retention_crc32_shift(ram_retention_crc32_raw(0, old ^ new, size), number of bytes after the changed place).
+ * @param [in] raw  linear CRC-32
+ * @param [in] len  number of zero bytes
+ * @return linear CRC-32 after len zero bytes
+*/
+uint32_t ram_retention_crc32_shift(uint32_t raw, size_t len);
+
+/**
+ * @brief Fletcher-32 of the data, taken over 16-bit little endian words. An odd last byte is padded with zero.
+ * @param [in] data pointer to the data
+ * @param [in] len  length of the data in bytes
+ * @return Fletcher-32
+*/
+uint32_t ram_retention_fletcher32(const uint8_t *data, size_t len);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RAM_RETENTION_CRC_H */
@@ -0,0 +1,117 @@
+/**
+ * @author Batto1
+ * @brief  Flush points of the deferred commit mode (CONFIG_APP_RETENTION_DEFERRED_COMMIT).
+ *         Dirty ram retention variables are committed before reboot, on fatal errors, before System OFF and optionally periodically.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/fatal.h>
+#include <zephyr/sys/reboot.h>
+#include <zephyr/logging/log.h>
+
+#if defined(CONFIG_PM)
+#include <zephyr/pm/pm.h>
+#endif
+
+#include "ram_retention_utils.h"
+
+
+LOG_MODULE_DECLARE(ram_retention_utils, CONFIG_LOG_DEFAULT_LEVEL);
+
+
+
+#if defined(CONFIG_APP_RETENTION_DEFERRED_FLUSH_ON_REBOOT)
+
+/* sys_reboot() is wrapped at link time (-Wl,--wrap=sys_reboot), see CMakeLists.txt */
+FUNC_NORETURN void __real_sys_reboot(int type);
+
+FUNC_NORETURN void __wrap_sys_reboot(int type)
+{
+	ram_retained_flush();
+	__real_sys_reboot(type);
+}
+
+#endif /* CONFIG_APP_RETENTION_DEFERRED_FLUSH_ON_REBOOT */
+
+
+
+/* With CONFIG_APP_RETENTION_CRASH_HANDLER the handler of ram_retention_crash.c flushes instead. */
+#if defined(CONFIG_APP_RETENTION_DEFERRED_FLUSH_ON_FATAL) && !defined(CONFIG_APP_RETENTION_CRASH_HANDLER)
+
+/* Overrides the weak default handler, behaves the same after the flush. */
+void k_sys_fatal_error_handler(unsigned int reason, const z_arch_esf_t *esf)
+{
+	ARG_UNUSED(esf);
+
+	ram_retained_flush();
+
+	LOG_PANIC();
+	LOG_ERR("Halting system");
+	k_fatal_halt(reason);
+	CODE_UNREACHABLE;
+}
+
+#endif /* CONFIG_APP_RETENTION_DEFERRED_FLUSH_ON_FATAL && !CONFIG_APP_RETENTION_CRASH_HANDLER */
+
+
+
+#if defined(CONFIG_APP_RETENTION_DEFERRED_FLUSH_ON_SOFT_OFF)
+
+#if defined(CONFIG_PM)
+static void ram_retention_pm_state_entry(enum pm_state state)
+{
+	if (state == PM_STATE_SOFT_OFF) {
+		ram_retained_flush();
+	}
+}
+
+static struct pm_notifier ram_retention_pm_notifier = {
+	.state_entry = ram_retention_pm_state_entry,
+};
+#endif /* CONFIG_PM */
+
+#if defined(CONFIG_POWEROFF)
+/* sys_poweroff() is wrapped at link time (-Wl,--wrap=sys_poweroff), see CMakeLists.txt */
+FUNC_NORETURN void __real_sys_poweroff(void);
+
+FUNC_NORETURN void __wrap_sys_poweroff(void)
+{
+	ram_retained_flush();
+	__real_sys_poweroff();
+}
+#endif /* CONFIG_POWEROFF */
+
+#endif /* CONFIG_APP_RETENTION_DEFERRED_FLUSH_ON_SOFT_OFF */
+
+
+
+#if (CONFIG_APP_RETENTION_DEFERRED_FLUSH_PERIOD_MS > 0)
+
+static void ram_retention_flush_work_handler(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(ram_retention_flush_work, ram_retention_flush_work_handler);
+
+static void ram_retention_flush_work_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	ram_retained_flush();
+	(void)k_work_schedule(&ram_retention_flush_work, K_MSEC(CONFIG_APP_RETENTION_DEFERRED_FLUSH_PERIOD_MS));
+}
+
+#endif /* CONFIG_APP_RETENTION_DEFERRED_FLUSH_PERIOD_MS */
+
+
+
+SYS_INIT_SIMPLE(APPLICATION, 31)
+{
+#if defined(CONFIG_APP_RETENTION_DEFERRED_FLUSH_ON_SOFT_OFF) && defined(CONFIG_PM)
+	pm_notifier_register(&ram_retention_pm_notifier);
+#endif
+
+#if (CONFIG_APP_RETENTION_DEFERRED_FLUSH_PERIOD_MS > 0)
+	(void)k_work_schedule(&ram_retention_flush_work, K_MSEC(CONFIG_APP_RETENTION_DEFERRED_FLUSH_PERIOD_MS));
+#endif
+
+	return 0;
+}
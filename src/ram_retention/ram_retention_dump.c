@@ -0,0 +1,266 @@
+/**
+ * @author Batto1
+ * @brief  Binary dump and restore of the ram retention registry (CONFIG_APP_RETENTION_DUMP), see ram_retention_dump.h.
+ *         Dump copies the raw bytes of a variable in chunks with IRQs locked, so that the CRC-32 and the write callback see the same
+ *         bytes even if an ISR commits the variable during the dump. Restore checks the structure and the CRC-32 of the whole frame
+ *         before the first variable is written.
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/logging/log.h>
+
+#include "ram_retention_utils.h"
+#include "ram_retention_crc.h"
+#include "ram_retention_dump.h"
+
+#if defined(CONFIG_APP_RETENTION_SPILL)
+#include "ram_retention_spill.h"
+#endif
+
+
+LOG_MODULE_DECLARE(ram_retention_utils, CONFIG_LOG_DEFAULT_LEVEL);
+
+
+/* Raw bytes of a record are padded to a multiple of 4 */
+#define DUMP_ALIGN sizeof(uint32_t)
+
+static const uint8_t dump_pad[DUMP_ALIGN - 1];
+
+/* Raw bytes copied with IRQs locked at once */
+#define DUMP_CHUNK 64
+
+struct dumpStream{
+	ram_retained_dump_write_t	write;
+	void *				user_data;
+	uint32_t			crc;		// CRC-32 of the frame written so far
+};
+
+
+
+static int dump_put(struct dumpStream *a_p_stream, const void *a_p_data, size_t a_len)
+{
+	a_p_stream->crc = ram_retention_crc32_update(a_p_stream->crc, (const uint8_t *)a_p_data, a_len);
+
+	return a_p_stream->write(a_p_data, a_len, a_p_stream->user_data);
+}
+
+/* Raw bytes of a variable, each chunk is a snapshot taken with IRQs locked, a_write isn't called with IRQs locked. */
+static int dump_put_var(struct dumpStream *a_p_stream, const struct ramRetDescriptor *desc)
+{
+	uint8_t chunk[DUMP_CHUNK] __aligned(4);
+	const uint8_t *src = (const uint8_t *)desc->addr;
+	int err = 0;
+
+	for (size_t pos = 0; (pos < desc->size) && (err == 0); pos += DUMP_CHUNK) {
+		size_t len = MIN((size_t)DUMP_CHUNK, desc->size - pos);
+		unsigned int key = irq_lock();
+
+		memcpy(chunk, src + pos, len);
+		irq_unlock(key);
+
+		err = dump_put(a_p_stream, chunk, len);
+	}
+
+	return err;
+}
+
+/* Number of records, a_p_len is set to the length of the frame */
+static uint16_t dump_count(size_t *a_p_len)
+{
+	size_t len = sizeof(struct ramRetDumpHeader) + sizeof(uint32_t);
+	uint16_t count = 0;
+
+	STRUCT_SECTION_FOREACH(ramRetDescriptor, desc) {
+		len += sizeof(struct ramRetDumpRecord) + ROUND_UP(desc->size, DUMP_ALIGN);
+		count++;
+	}
+
+	*a_p_len = len;
+
+	return count;
+}
+
+static uint8_t dump_status(const struct ramRetDescriptor *desc)
+{
+	uint8_t status = 0;
+
+	if (ram_retained_check_integrity((enum ramRetIntegrity)desc->integrity, desc->addr, desc->crc_offset)) {
+		status |= RR_DUMP_STATUS_VALID;
+	}
+	if (atomic_test_bit(desc->state, RR_STATE_VALIDATED)) {
+		status |= RR_DUMP_STATUS_VALIDATED;
+	}
+	if (atomic_test_bit(desc->state, RR_STATE_DIRTY)) {
+		status |= RR_DUMP_STATUS_DIRTY;
+	}
+
+	return status;
+}
+
+size_t ram_retained_dump_size(void)
+{
+	size_t len;
+
+	(void)dump_count(&len);
+
+	return len;
+}
+
+int ram_retained_dump(ram_retained_dump_write_t a_write, void *a_user_data)
+{
+	struct dumpStream stream = {
+		.write		= a_write,
+		.user_data	= a_user_data,
+		.crc		= 0,
+	};
+	size_t len;
+	uint16_t count = dump_count(&len);
+	struct ramRetDumpHeader header = {
+		.magic		= sys_cpu_to_le32(RR_DUMP_MAGIC),
+		.version	= sys_cpu_to_le16(RR_DUMP_VERSION),
+		.count		= sys_cpu_to_le16(count),
+		.length		= sys_cpu_to_le32((uint32_t)len),
+	};
+
+	int err = dump_put(&stream, &header, sizeof(header));
+
+	STRUCT_SECTION_FOREACH(ramRetDescriptor, desc) {
+		if (err != 0) {
+			return err;
+		}
+
+		struct ramRetDumpRecord record = {
+			.id		= sys_cpu_to_le32(ram_retained_desc_id(desc)),
+			.size		= sys_cpu_to_le32((uint32_t)desc->size),
+			.layout		= sys_cpu_to_le32(desc->layout),
+			.integrity	= desc->integrity,
+			.status		= dump_status(desc),
+			.reserved	= 0,
+		};
+		size_t pad = ROUND_UP(desc->size, DUMP_ALIGN) - desc->size;
+
+		err = dump_put(&stream, &record, sizeof(record));
+		if (err == 0) {
+			err = dump_put_var(&stream, desc);
+		}
+		if ((err == 0) && (pad != 0U)) {
+			err = dump_put(&stream, dump_pad, pad);
+		}
+	}
+
+	if (err == 0) {
+		uint32_t crc = sys_cpu_to_le32(stream.crc);
+
+		err = a_write(&crc, sizeof(crc), a_user_data);
+	}
+
+	return (err != 0) ? err : (int)len;
+}
+
+
+
+static const struct ramRetDescriptor *restore_find(uint32_t a_id)
+{
+	STRUCT_SECTION_FOREACH(ramRetDescriptor, desc) {
+		if (ram_retained_desc_id(desc) == a_id) {
+			return desc;
+		}
+	}
+
+	return NULL;
+}
+
+/* Write one record back, false if it is skipped */
+static bool restore_record(const struct ramRetDumpRecord *a_p_record, const uint8_t *a_p_data)
+{
+	uint32_t id = sys_le32_to_cpu(a_p_record->id);
+	const struct ramRetDescriptor *desc = restore_find(id);
+
+	if ((desc == NULL) || (desc->size != sys_le32_to_cpu(a_p_record->size)) ||
+	    (desc->layout != sys_le32_to_cpu(a_p_record->layout))) {
+		LOG_WRN("Ram ret restore skipped unknown variable 0x%08" PRIx32, id);
+		return false;
+	}
+
+	if (!ram_retained_check_integrity((enum ramRetIntegrity)desc->integrity, a_p_data, desc->crc_offset)) {
+		LOG_WRN("Ram ret restore skipped invalid variable <%s>", desc->name);
+		return false;
+	}
+
+	unsigned int key = irq_lock();
+
+	memcpy(desc->addr, a_p_data, desc->size);
+	atomic_clear_bit(desc->state, RR_STATE_DIRTY);
+	atomic_set_bit(desc->state, RR_STATE_VALIDATED);
+
+	irq_unlock(key);
+
+#if defined(CONFIG_APP_RETENTION_SPILL)
+	ram_retained_spill_mark(desc);
+#endif
+
+	return true;
+}
+
+/* Walk the records of a checked frame, they are only written if a_apply is set.
+ * Returns the number of records written, -EINVAL if a record doesn't fit in the frame.
+ */
+static int restore_walk(const uint8_t *a_p_frame, size_t a_len, bool a_apply)
+{
+	const struct ramRetDumpHeader *header = (const struct ramRetDumpHeader *)a_p_frame;
+	uint16_t count = sys_le16_to_cpu(header->count);
+	size_t pos = sizeof(*header);
+	size_t end = a_len - sizeof(uint32_t);
+	int written = 0;
+
+	for (uint16_t i = 0; i < count; i++) {
+		if ((end - pos) < sizeof(struct ramRetDumpRecord)) {
+			return -EINVAL;
+		}
+
+		const struct ramRetDumpRecord *record = (const struct ramRetDumpRecord *)(a_p_frame + pos);
+		size_t size = sys_le32_to_cpu(record->size);
+
+		pos += sizeof(*record);
+		if (size > (end - pos)) {
+			return -EINVAL;
+		}
+
+		if (a_apply && restore_record(record, a_p_frame + pos)) {
+			written++;
+		}
+
+		pos += ROUND_UP(size, DUMP_ALIGN);
+	}
+
+	return (pos == end) ? written : -EINVAL;
+}
+
+int ram_retained_restore(const void *a_p_frame, size_t a_len)
+{
+	const uint8_t *frame = (const uint8_t *)a_p_frame;
+	const struct ramRetDumpHeader *header = (const struct ramRetDumpHeader *)a_p_frame;
+
+	if ((((uintptr_t)frame % DUMP_ALIGN) != 0U) || (a_len < (sizeof(*header) + sizeof(uint32_t)))) {
+		return -EINVAL;
+	}
+
+	size_t len = sys_le32_to_cpu(header->length);
+
+	if ((sys_le32_to_cpu(header->magic) != RR_DUMP_MAGIC) || (sys_le16_to_cpu(header->version) != RR_DUMP_VERSION) ||
+	    (len > a_len) || (len < (sizeof(*header) + sizeof(uint32_t))) || ((len % DUMP_ALIGN) != 0U)) {
+		return -EINVAL;
+	}
+
+	if (ram_retention_crc32(frame, len - sizeof(uint32_t)) != sys_get_le32(frame + len - sizeof(uint32_t))) {
+		return -EBADMSG;
+	}
+
+	int err = restore_walk(frame, len, false);
+
+	return (err < 0) ? err : restore_walk(frame, len, true);
+}
@@ -0,0 +1,102 @@
+/**
+ * @author Batto1
+ * @brief  Binary dump and restore of the ram retention registry (CONFIG_APP_RETENTION_DUMP), i.e. for snapshots of retained state on a
+ *         test bench. Every variable defined with RR_Init_Var_Ram_Retention() is written as one record of a single self-describing frame,
+ *         streamed from retained RAM through a write callback.
+ * @note   Frame is little endian and 4-byte aligned throughout:
+ *         struct ramRetDumpHeader, then for each variable a struct ramRetDumpRecord followed by its raw bytes padded to a multiple of 4,
+ *         then the CRC-32 of everything before it.
+ * @note   Variables are identified by ram_retained_desc_id(), so a frame can be restored into another build as long as names, sizes
+ *         and layouts of the variables match.
+ */
+
+#ifndef RAM_RETENTION_DUMP_H
+#define RAM_RETENTION_DUMP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <zephyr/sys/util.h>
+
+#include "ram_retention_utils.h"
+
+
+#define RR_DUMP_MAGIC		0x31445252	// "RRD1"
+#define RR_DUMP_VERSION		1
+
+/**
+ * @brief Header of a frame.
+*/
+struct ramRetDumpHeader{
+	uint32_t	magic;			// RR_DUMP_MAGIC
+	uint16_t	version;		// RR_DUMP_VERSION
+	uint16_t	count;			// number of records
+	uint32_t	length;			// length of the whole frame, including the header and the trailing CRC-32
+};
+
+/**
+ * @brief Header of a record, raw bytes of the variable follow it.
+*/
+struct ramRetDumpRecord{
+	uint32_t	id;			// ram_retained_desc_id() of the variable
+	uint32_t	size;			// sizeof the variable, number of raw bytes
+	uint32_t	layout;			// layout hash of the variable, 0 for types without a layout header
+	uint8_t		integrity;		// integrity check algorithm of the variable, enum ramRetIntegrity
+	uint8_t		status;			// RR_DUMP_STATUS_* of the variable at the time of the dump
+	uint16_t	reserved;		// 0
+};
+
+/**
+ * @brief Bits of ramRetDumpRecord.status.
+*/
+#define RR_DUMP_STATUS_VALID		BIT(0)	// raw bytes pass the integrity check
+#define RR_DUMP_STATUS_VALIDATED	BIT(1)	// validated by the boot pass or by its first access
+#define RR_DUMP_STATUS_DIRTY		BIT(2)	// changed with RR_Var_Ram_Ret_Defer() and not committed yet
+
+/**
+ * @brief Write callback of ram_retained_dump(), i.e. a UART or a shell transport.
+ * @param [in] a_p_data    pointer to the next bytes of the frame, only valid during the call
+ * @param [in] a_len       number of bytes
+ * @param [in] a_user_data user data given to ram_retained_dump()
+ * @return 0 on success, a negative error stops the dump.
+*/
+typedef int (*ram_retained_dump_write_t)(const void *a_p_data, size_t a_len, void *a_user_data);
+
+/**
+ * @brief Length of the frame ram_retained_dump() writes.
+*/
+size_t ram_retained_dump_size(void);
+
+/**
+ * @brief Stream every registered variable as one frame.
+ * @note  Raw bytes of a variable are copied to a_write in chunks of 64 bytes, each chunk with IRQs locked, and the frame CRC-32 is
+ *        computed over the copies, so a frame always passes its own CRC-32 check. Variables aren't locked as a whole: a variable
+ *        changed during the dump may be recorded torn, its record then fails the integrity check of the variable and
+ *        ram_retained_restore() skips it. Status of a record is taken just before its raw bytes.
+ * @param [in] a_write     write callback
+ * @param [in] a_user_data passed to a_write
+ * @return length of the frame, or the negative error of a_write.
+*/
+int ram_retained_dump(ram_retained_dump_write_t a_write, void *a_user_data);
+
+/**
+ * @brief Write the variables of a frame back into retained RAM.
+ *        Frame is checked as a whole first. A record is only written if its variable is registered with the same size and layout and
+ *        its raw bytes pass the integrity check of the variable, other records are skipped. Each variable is written with
+ *        interrupts locked and marked as validated.
+ * @param [in] a_p_frame pointer to the frame, 4-byte aligned
+ * @param [in] a_len     number of bytes available at a_p_frame
+ * @return number of variables written, -EINVAL if the frame is malformed, -EBADMSG if its CRC-32 doesn't match.
+*/
+int ram_retained_restore(const void *a_p_frame, size_t a_len);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RAM_RETENTION_DUMP_H */
@@ -0,0 +1,221 @@
+/**
+ * @author Batto1
+ * @brief  INTERNAL. Retention control backend of ram retention, selected with the CONFIG_APP_RETENTION_BACKEND Kconfig choice.
+ *         Every backend is a set of static inline functions over the register path of its SoC, so that the library calls them directly:
+ *         - nRF52 POWER RAM[n] registers (CONFIG_APP_RETENTION_BACKEND_POWER)
+ *         - nRF53 VMC RAM[n] registers (CONFIG_APP_RETENTION_BACKEND_VMC)
+ *         - nRF54L MEMCONF POWER[n].RET registers (CONFIG_APP_RETENTION_BACKEND_MEMCONF)
+ *         - no retention control, i.e. the nRF5340 network core (CONFIG_APP_RETENTION_BACKEND_NONE)
+ *         - emulated nRF52 POWER peripheral (CONFIG_APP_RETENTION_BACKEND_POWER_EMUL), see ram_retention_power_emul.h
+ *
+ *         SRAM of every backend is split into RR_HAL_SMALL_BLOCK_COUNT blocks of RR_HAL_SMALL_SECTIONS_PER_BLOCK sections, optionally
+ *         followed by one block of RR_HAL_LARGE_SECTIONS_PER_BLOCK larger sections. Section n of a block is retained by bit
+ *         RR_HAL_RETENTION_POS + n of its register.
+ */
+
+#ifndef RAM_RETENTION_HAL_H
+#define RAM_RETENTION_HAL_H
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/devicetree.h>
+
+#if defined(CONFIG_APP_RETENTION_BACKEND_POWER_EMUL)
+#include "ram_retention_power_emul.h"
+#elif defined(CONFIG_APP_RETENTION_BACKEND_VMC)
+#include <hal/nrf_vmc.h>
+#include <hal/nrf_reset.h>
+#elif defined(CONFIG_APP_RETENTION_BACKEND_MEMCONF)
+#include <hal/nrf_memconf.h>
+#include <hal/nrf_reset.h>
+#elif defined(CONFIG_APP_RETENTION_BACKEND_NONE)
+#include <zephyr/drivers/hwinfo.h>
+#else
+#include <hal/nrf_power.h>
+#endif
+
+
+#if defined(CONFIG_APP_RETENTION_BACKEND_VMC)
+
+/* nRF5340 application core: 8 blocks of sixteen 4 KiB sections */
+#define RR_HAL_SMALL_SECTION_SIZE		4096
+#define RR_HAL_SMALL_SECTIONS_PER_BLOCK		16
+#define RR_HAL_SMALL_BLOCK_COUNT		8
+#define RR_HAL_LARGE_SECTION_SIZE		0
+#define RR_HAL_LARGE_SECTIONS_PER_BLOCK		0
+#define RR_HAL_RETENTION_POS			16
+
+#elif defined(CONFIG_APP_RETENTION_BACKEND_MEMCONF)
+
+/* nRF54L: POWER[0].RET, one bit for each 32 KiB RAM block */
+#define RR_HAL_SMALL_SECTION_SIZE		32768
+#define RR_HAL_SMALL_SECTIONS_PER_BLOCK		8
+#define RR_HAL_SMALL_BLOCK_COUNT		1
+#define RR_HAL_LARGE_SECTION_SIZE		0
+#define RR_HAL_LARGE_SECTIONS_PER_BLOCK		0
+#define RR_HAL_RETENTION_POS			0
+
+#elif defined(CONFIG_APP_RETENTION_BACKEND_NONE)
+
+/* Retention isn't controlled by the library, the whole SRAM is a single section. */
+#define RR_HAL_SMALL_SECTION_SIZE		RR_HAL_SRAM_SIZE
+#define RR_HAL_SMALL_SECTIONS_PER_BLOCK		1
+#define RR_HAL_SMALL_BLOCK_COUNT		1
+#define RR_HAL_LARGE_SECTION_SIZE		0
+#define RR_HAL_LARGE_SECTIONS_PER_BLOCK		0
+#define RR_HAL_RETENTION_POS			0
+
+#else
+
+/* nRF52 and its emulation: 8 blocks of two 4 KiB sections, a 9th block of up to 16 sections of 32 KiB */
+#define RR_HAL_SMALL_SECTION_SIZE		4096
+#define RR_HAL_SMALL_SECTIONS_PER_BLOCK		2
+#define RR_HAL_SMALL_BLOCK_COUNT		8
+#define RR_HAL_LARGE_SECTION_SIZE		32768
+#define RR_HAL_LARGE_SECTIONS_PER_BLOCK		16
+#define RR_HAL_RETENTION_POS			16
+
+#endif
+
+
+#if defined(CONFIG_APP_RETENTION_BACKEND_POWER_EMUL)
+
+/* Emulated SRAM starts at the RAM section of the ".ram_retained" section */
+#define RR_HAL_SRAM_BEGIN	rr_power_emul_sram_begin()
+#define RR_HAL_SRAM_SIZE	CONFIG_APP_RETENTION_BACKEND_POWER_EMUL_SRAM_SIZE
+
+static inline int rr_hal_init(void)
+{
+	return 0;
+}
+
+static inline void rr_hal_ram_retention_set(uint8_t a_block, uint32_t a_mask)
+{
+	rr_power_emul_mask_on(a_block, a_mask);
+}
+
+static inline void rr_hal_ram_retention_clear(uint8_t a_block, uint32_t a_mask)
+{
+	rr_power_emul_mask_off(a_block, a_mask);
+}
+
+static inline uint32_t rr_hal_reset_reason(void)
+{
+	return ram_retention_emul_reset_reason();
+}
+
+#elif defined(CONFIG_APP_RETENTION_BACKEND_VMC)
+
+#define RR_HAL_SRAM_BEGIN	((uintptr_t)DT_REG_ADDR(DT_NODELABEL(sram0)))
+#define RR_HAL_SRAM_SIZE	((uintptr_t)DT_REG_SIZE(DT_NODELABEL(sram0)))
+
+static inline int rr_hal_init(void)
+{
+	return 0;
+}
+
+static inline void rr_hal_ram_retention_set(uint8_t a_block, uint32_t a_mask)
+{
+	nrf_vmc_ram_block_retention_set(NRF_VMC, a_block, (nrf_vmc_retention_t)a_mask);
+}
+
+static inline void rr_hal_ram_retention_clear(uint8_t a_block, uint32_t a_mask)
+{
+	nrf_vmc_ram_block_retention_clear(NRF_VMC, a_block, (nrf_vmc_retention_t)a_mask);
+}
+
+static inline uint32_t rr_hal_reset_reason(void)
+{
+	return nrf_reset_resetreas_get(NRF_RESET);
+}
+
+#elif defined(CONFIG_APP_RETENTION_BACKEND_MEMCONF)
+
+#define RR_HAL_SRAM_BEGIN	((uintptr_t)DT_REG_ADDR(DT_NODELABEL(sram0)))
+#define RR_HAL_SRAM_SIZE	((uintptr_t)DT_REG_SIZE(DT_NODELABEL(sram0)))
+
+static inline int rr_hal_init(void)
+{
+	return 0;
+}
+
+static inline void rr_hal_ram_retention_set(uint8_t a_block, uint32_t a_mask)
+{
+	nrf_memconf_ramblock_ret_mask_enable_set(NRF_MEMCONF, a_block, a_mask, true);
+}
+
+static inline void rr_hal_ram_retention_clear(uint8_t a_block, uint32_t a_mask)
+{
+	nrf_memconf_ramblock_ret_mask_enable_set(NRF_MEMCONF, a_block, a_mask, false);
+}
+
+static inline uint32_t rr_hal_reset_reason(void)
+{
+	return nrf_reset_resetreas_get(NRF_RESET);
+}
+
+#elif defined(CONFIG_APP_RETENTION_BACKEND_NONE)
+
+#define RR_HAL_SRAM_BEGIN	((uintptr_t)DT_REG_ADDR(DT_CHOSEN(zephyr_sram)))
+#define RR_HAL_SRAM_SIZE	((uintptr_t)DT_REG_SIZE(DT_CHOSEN(zephyr_sram)))
+
+static inline int rr_hal_init(void)
+{
+	return 0;
+}
+
+/* Retention isn't controllable by this core. */
+static inline void rr_hal_ram_retention_set(uint8_t a_block, uint32_t a_mask)
+{
+	ARG_UNUSED(a_block);
+	ARG_UNUSED(a_mask);
+}
+
+static inline void rr_hal_ram_retention_clear(uint8_t a_block, uint32_t a_mask)
+{
+	ARG_UNUSED(a_block);
+	ARG_UNUSED(a_mask);
+}
+
+/* Reset cause of hwinfo, 0 after a power-on or brown-out reset same as RESETREAS. */
+static inline uint32_t rr_hal_reset_reason(void)
+{
+	uint32_t cause = 0;
+
+	if ((hwinfo_get_reset_cause(&cause) != 0) || ((cause & (RESET_POR | RESET_BROWNOUT)) != 0U)) {
+		return 0;
+	}
+
+	return cause;
+}
+
+#else
+
+#define RR_HAL_SRAM_BEGIN	((uintptr_t)DT_REG_ADDR(DT_NODELABEL(sram0)))
+#define RR_HAL_SRAM_SIZE	((uintptr_t)DT_REG_SIZE(DT_NODELABEL(sram0)))
+
+static inline int rr_hal_init(void)
+{
+	return 0;
+}
+
+static inline void rr_hal_ram_retention_set(uint8_t a_block, uint32_t a_mask)
+{
+	nrf_power_rampower_mask_on(NRF_POWER, a_block, a_mask);
+}
+
+static inline void rr_hal_ram_retention_clear(uint8_t a_block, uint32_t a_mask)
+{
+	nrf_power_rampower_mask_off(NRF_POWER, a_block, a_mask);
+}
+
+static inline uint32_t rr_hal_reset_reason(void)
+{
+	return nrf_power_resetreas_get(NRF_POWER);
+}
+
+#endif /* CONFIG_APP_RETENTION_BACKEND_POWER_EMUL */
+
+#endif /* RAM_RETENTION_HAL_H */
@@ -0,0 +1,122 @@
+/**
+ * @author Batto1
+ * @brief  Emulated nRF52 POWER peripheral (CONFIG_APP_RETENTION_BACKEND_POWER_EMUL), see ram_retention_power_emul.h.
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include "ram_retention_utils.h"
+#include "ram_retention_power_emul.h"
+
+
+/* Granularity the ".ram_retained" section is scrambled with, the smallest RAM section */
+#define EMUL_SECTION_SIZE 4096
+
+/* RAM[n].POWER after a power-on reset, every section powered, none retained */
+#define EMUL_RAM_POWER_RESET 0x0000FFFF
+
+/* Bounds of the ".ram_retained" linker section, see ram_retention_noinit.ld */
+extern char __ram_retained_start[];
+extern char __ram_retained_end[];
+
+static uint32_t ram_power[RR_RAM_BLOCK_COUNT] = {
+	[0 ... (RR_RAM_BLOCK_COUNT - 1)] = EMUL_RAM_POWER_RESET,
+};
+static uint32_t resetreas = RR_EMUL_RESETREAS_POWER_ON;
+static uint32_t writes;
+
+/* xorshift32 state of the scrambled RAM content, seeded so that runs are repeatable */
+static uint32_t scramble_state = 0x52524d55;
+
+
+
+uintptr_t rr_power_emul_sram_begin(void)
+{
+	return ROUND_DOWN((uintptr_t)__ram_retained_start, EMUL_SECTION_SIZE);
+}
+
+void rr_power_emul_mask_on(uint8_t a_block, uint32_t a_mask)
+{
+	ram_power[a_block] |= a_mask;
+	writes++;
+}
+
+void rr_power_emul_mask_off(uint8_t a_block, uint32_t a_mask)
+{
+	ram_power[a_block] &= ~a_mask;
+	writes++;
+}
+
+uint32_t ram_retention_emul_ram_power(uint8_t a_block)
+{
+	return ram_power[a_block];
+}
+
+uint32_t ram_retention_emul_writes(void)
+{
+	return writes;
+}
+
+uint32_t ram_retention_emul_reset_reason(void)
+{
+	return resetreas;
+}
+
+/* true if the retention bit of the RAM section the address is in is set */
+static bool emul_section_retained(const uint8_t *addr)
+{
+	uint32_t masks[RR_RAM_BLOCK_COUNT] = {0};
+
+	if (ram_retain_masks_add(masks, addr, 1) != 0) {
+		return false;
+	}
+
+	for (size_t block = 0; block < RR_RAM_BLOCK_COUNT; block++) {
+		if ((masks[block] & ~ram_power[block]) != 0U) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void emul_scramble(uint8_t *begin, uint8_t *end)
+{
+	for (uint8_t *p = begin; p < end; p++) {
+		scramble_state ^= scramble_state << 13;
+		scramble_state ^= scramble_state >> 17;
+		scramble_state ^= scramble_state << 5;
+		*p = (uint8_t)scramble_state;
+	}
+}
+
+void ram_retention_emul_reset(uint32_t a_resetreas)
+{
+	bool power_on = (a_resetreas == RR_EMUL_RESETREAS_POWER_ON);
+	bool system_off = ((a_resetreas & RR_EMUL_RESETREAS_OFF) != 0U);
+	uint8_t *section = (uint8_t *)__ram_retained_start;
+
+	/* RAM keeps its content through every other reset, retention bits only matter in System OFF. */
+	while (section < (uint8_t *)__ram_retained_end) {
+		uint8_t *section_end = MIN((uint8_t *)ROUND_DOWN((uintptr_t)section + EMUL_SECTION_SIZE, EMUL_SECTION_SIZE),
+					   (uint8_t *)__ram_retained_end);
+
+		if (power_on || (system_off && !emul_section_retained(section))) {
+			emul_scramble(section, section_end);
+		}
+		section = section_end;
+	}
+
+	if (power_on) {
+		for (size_t block = 0; block < RR_RAM_BLOCK_COUNT; block++) {
+			ram_power[block] = EMUL_RAM_POWER_RESET;
+		}
+	}
+
+	resetreas = a_resetreas;
+	writes = 0;
+
+	ram_retention_emul_reinit();
+}
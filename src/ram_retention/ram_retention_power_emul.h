@@ -0,0 +1,78 @@
+/**
+ * @author Batto1
+ * @brief  Emulated nRF52 POWER peripheral (CONFIG_APP_RETENTION_BACKEND_POWER_EMUL), so that ram retention runs off target, i.e. on native_sim.
+ *         RAM[n].POWER retention bits and RESETREAS are modelled as plain variables, and ram_retention_emul_reset() emulates a reset
+ *         that keeps or scrambles the RAM sections of the ".ram_retained" section by their retention bits.
+ * @note   Emulated SRAM starts at the 4 KiB section the ".ram_retained" section starts in, it is CONFIG_APP_RETENTION_BACKEND_POWER_EMUL_SRAM_SIZE long.
+ *         Only the ".ram_retained" section is scrambled, the rest of the host memory isn't touched.
+ */
+
+#ifndef RAM_RETENTION_POWER_EMUL_H
+#define RAM_RETENTION_POWER_EMUL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/**
+ * @brief RESETREAS of a power-on reset, see ram_retention_emul_reset().
+*/
+#define RR_EMUL_RESETREAS_POWER_ON	0
+
+/**
+ * @brief RESETREAS of a soft reset (NRF_POWER_RESETREAS_SREQ_MASK), see ram_retention_emul_reset().
+*/
+#define RR_EMUL_RESETREAS_SOFT		0x00000004
+
+/**
+ * @brief RESETREAS of a wake up from System OFF by GPIO (NRF_POWER_RESETREAS_OFF_MASK), see ram_retention_emul_reset().
+*/
+#define RR_EMUL_RESETREAS_OFF		0x00010000
+
+/**
+ * @brief Emulate a reset, then run the boot pass of ram retention again.
+ *        Wake up from System OFF (RR_EMUL_RESETREAS_OFF) scrambles the RAM sections of the ".ram_retained" section whose RAM OFF retention bit is clear.
+ *        A power-on reset scrambles all of them and clears the retention bits. Other resets keep RAM as it is, same as on target.
+ * @note  Only the state of the library is reset, other static variables of the application keep their value.
+ * @param [in] a_resetreas RESETREAS after the reset, i.e. RR_EMUL_RESETREAS_OFF, RR_EMUL_RESETREAS_SOFT or RR_EMUL_RESETREAS_POWER_ON
+*/
+void ram_retention_emul_reset(uint32_t a_resetreas);
+
+/**
+ * @brief Value of the emulated RAM[n].POWER register.
+ * @param [in] a_block RAM block, 0 to RR_RAM_BLOCK_COUNT - 1
+*/
+uint32_t ram_retention_emul_ram_power(uint8_t a_block);
+
+/**
+ * @brief Number of RAM[n].POWERSET and RAM[n].POWERCLR register writes since the last emulated reset, including its boot pass.
+*/
+uint32_t ram_retention_emul_writes(void);
+
+/**
+ * @brief Value of the emulated RESETREAS register.
+*/
+uint32_t ram_retention_emul_reset_reason(void);
+
+/**
+ * @brief INTERNAL. Accessors used by ram_retention_hal.h.
+*/
+uintptr_t rr_power_emul_sram_begin(void);
+void rr_power_emul_mask_on(uint8_t a_block, uint32_t a_mask);
+void rr_power_emul_mask_off(uint8_t a_block, uint32_t a_mask);
+
+/**
+ * @brief INTERNAL. Reset the state of the library and run its boot pass again, defined in ram_retention_utils.c.
+*/
+void ram_retention_emul_reinit(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RAM_RETENTION_POWER_EMUL_H */
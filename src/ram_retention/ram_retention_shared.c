@@ -0,0 +1,103 @@
+/**
+ * @author Batto1
+ * @brief  Retained region shared by the nRF5340 cores (CONFIG_APP_RETENTION_SHARED), see ram_retention_shared.h.
+ *         Every slot is a RamRetTypeDeclareAB() variable: the owner commits it with ram_retained_ab_write(), the other core
+ *         reads it with ram_retained_ab_read_checked(), which checks the CRC of its copy since the reader never validates the slot.
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/logging/log.h>
+
+#include "ram_retention_utils.h"
+#include "ram_retention_shared.h"
+
+
+LOG_MODULE_DECLARE(ram_retention_utils, CONFIG_LOG_DEFAULT_LEVEL);
+
+
+#define SHARED_NODE DT_CHOSEN(rr_shared_ram)
+
+struct ramRetSharedPayload{
+	uint32_t	len;					// size of the state
+	uint8_t		data[CONFIG_APP_RETENTION_SHARED_SLOT_SIZE];
+};
+
+RamRetTypeDeclareAB(struct ramRetSharedPayload, RamRetSharedSlot);
+
+struct ramRetSharedRegion{
+	RamRetSharedSlot	slot[RR_SHARED_CORE_COUNT];
+};
+
+BUILD_ASSERT(sizeof(struct ramRetSharedRegion) <= DT_REG_SIZE(SHARED_NODE), "shared retained region is too small");
+
+/* Same address on both cores, the region isn't linked by either of them. */
+#define SHARED_REGION ((struct ramRetSharedRegion *)DT_REG_ADDR(SHARED_NODE))
+
+#define PAYLOAD_OFFSET	offsetof(RamRetSharedSlot, rr_slot[0].rr_var)
+#define SLOT_SIZE	_RR_AB_SLOT_SIZE(RamRetSharedSlot)
+
+
+
+int ram_retained_shared_publish(const void *a_p_data, size_t a_len)
+{
+	if (a_len > CONFIG_APP_RETENTION_SHARED_SLOT_SIZE) {
+		return -EINVAL;
+	}
+
+	struct ramRetSharedPayload payload;
+
+	payload.len = (uint32_t)a_len;
+	memcpy(payload.data, a_p_data, a_len);
+
+	/* Bytes after the state are left as they are, they are covered by the CRC of the slot anyway. */
+	return ram_retained_ab_write(&SHARED_REGION->slot[RR_SHARED_CORE_SELF], PAYLOAD_OFFSET, &payload,
+				     offsetof(struct ramRetSharedPayload, data) + a_len, SLOT_SIZE);
+}
+
+int ram_retained_shared_consume(enum ramRetSharedCore a_core, void *a_p_data, size_t a_size, uint32_t *a_p_seq)
+{
+	__ASSERT_NO_MSG(a_core < RR_SHARED_CORE_COUNT);
+
+	struct ramRetSharedPayload payload;
+	int err = ram_retained_ab_read_checked(&SHARED_REGION->slot[a_core], PAYLOAD_OFFSET, &payload, sizeof(payload),
+					       SLOT_SIZE, a_p_seq);
+
+	if (err != 0) {
+		return err;
+	}
+
+	if (payload.len > CONFIG_APP_RETENTION_SHARED_SLOT_SIZE) {
+		return -ENODATA;
+	}
+
+	memcpy(a_p_data, payload.data, MIN(a_size, payload.len));
+
+	return (int)payload.len;
+}
+
+/* Each core repairs its own slot only, the other core may be reading it.
+ * A commit torn by a reset of this core is dropped and the previous state stays.
+ */
+static int ram_retention_shared_init(const struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	RamRetSharedSlot *own = &SHARED_REGION->slot[RR_SHARED_CORE_SELF];
+
+	if (!ram_retained_recover_ab(own, offsetof(RamRetSharedSlot, crc))) {
+		memset(own, 0, sizeof(*own));
+	}
+
+#if defined(CONFIG_SOC_NRF5340_CPUAPP)
+	/* Region is in application core SRAM, retention of both slots is set here. */
+	(void)ram_range_retain(SHARED_REGION, sizeof(struct ramRetSharedRegion), true);
+#endif
+
+	return 0;
+}
+
+SYS_INIT(ram_retention_shared_init, APPLICATION, 31);
@@ -0,0 +1,68 @@
+/**
+ * @author Batto1
+ * @brief  Retained region shared by the nRF5340 application and network cores (CONFIG_APP_RETENTION_SHARED).
+ *         Each core owns one double buffered (A/B) slot and is its only writer. A core publishes its state with
+ *         ram_retained_shared_publish() and reads the last committed state of the other core with ram_retained_shared_consume(),
+ *         also after a reset of either core, without an IPC exchange.
+ * @note   Region is the devicetree node chosen with "rr,shared-ram", it must be the same node in the devicetree of both cores and
+ *         mustn't be used by either linker, i.e. a reserved part of application core SRAM.
+ */
+
+#ifndef RAM_RETENTION_SHARED_H
+#define RAM_RETENTION_SHARED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <inttypes.h>
+
+
+/**
+ * @brief Owners of the slots of the shared retained region.
+*/
+enum ramRetSharedCore{
+	RR_SHARED_CORE_APP = 0,		// nRF5340 application core
+	RR_SHARED_CORE_NET,		// nRF5340 network core
+	RR_SHARED_CORE_COUNT
+};
+
+/**
+ * @brief Slot owned by the core the code is built for, and the slot of the other core.
+*/
+#if defined(CONFIG_SOC_NRF5340_CPUNET)
+#define RR_SHARED_CORE_SELF RR_SHARED_CORE_NET
+#define RR_SHARED_CORE_PEER RR_SHARED_CORE_APP
+#else
+#define RR_SHARED_CORE_SELF RR_SHARED_CORE_APP
+#define RR_SHARED_CORE_PEER RR_SHARED_CORE_NET
+#endif
+
+
+/**
+ * @brief Commit a new state to the slot of this core. The previous state stays readable until the new one is complete,
+ *        so a reset in the middle of the commit keeps the previous state.
+ * @note  Lock-free, single writer: a publish preempting another publish on the same core gets -EBUSY.
+ * @param [in] a_p_data pointer to the state
+ * @param [in] a_len    size of the state, at most CONFIG_APP_RETENTION_SHARED_SLOT_SIZE
+ * @return 0 on success, -EINVAL if a_len is too big, -EBUSY if another publish is in progress.
+*/
+int ram_retained_shared_publish(const void *a_p_data, size_t a_len);
+
+/**
+ * @brief Read the last committed state of a slot, i.e. the one of RR_SHARED_CORE_PEER. Lock-free, never waits for the writer.
+ * @param [in]  a_core   owner of the slot
+ * @param [out] a_p_data buffer of the state, at most a_size bytes are copied
+ * @param [in]  a_size   size of the buffer
+ * @param [out] a_p_seq  sequence number of the state, grows with every publish. Can be NULL.
+ * @return size of the state (can be more than a_size), -ENODATA if the slot holds no committed state, i.e. after a power-on reset.
+*/
+int ram_retained_shared_consume(enum ramRetSharedCore a_core, void *a_p_data, size_t a_size, uint32_t *a_p_seq);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RAM_RETENTION_SHARED_H */
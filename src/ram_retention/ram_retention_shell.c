@@ -0,0 +1,188 @@
+/**
+ * @author Batto1
+ * @brief  Shell commands of ram retention (CONFIG_APP_RETENTION_SHELL).
+ */
+
+#include <inttypes.h>
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+
+#include "ram_retention_utils.h"
+
+#if defined(CONFIG_APP_RETENTION_DUMP)
+#include <string.h>
+#include <zephyr/sys/base64.h>
+#include <zephyr/sys/byteorder.h>
+#include "ram_retention_dump.h"
+#endif
+
+
+
+static int cmd_rr_stats(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	const struct ramRetBootStats *boot = ram_retained_boot_stats();
+
+	if (boot == NULL) {
+		shell_error(sh, "CONFIG_APP_RETENTION_STATS isn't enabled");
+		return -ENOTSUP;
+	}
+
+	shell_print(sh, "%-24s %10s %8s %10s %10s %10s %8s %8s",
+		    "name", "validate", "commits", "min", "avg", "max", "crc_err", "repairs");
+
+	STRUCT_SECTION_FOREACH(ramRetDescriptor, desc) {
+		const struct ramRetStats *stats = ram_retained_stats(desc);
+
+		if (stats == NULL) {
+			continue;
+		}
+
+		unsigned int key = irq_lock();
+		struct ramRetStats copy = *stats;
+
+		irq_unlock(key);
+
+		uint32_t avg = (copy.commit_count != 0U) ? (uint32_t)(copy.commit_total / copy.commit_count) : 0U;
+
+		shell_print(sh, "%-24s %10" PRIu32 " %8" PRIu32 " %10" PRIu32 " %10" PRIu32 " %10" PRIu32 " %8" PRIu32 " %8" PRIu32,
+			    desc->name, copy.validate_cycles, copy.commit_count,
+			    (copy.commit_count != 0U) ? copy.commit_min : 0U, avg, copy.commit_max,
+			    copy.crc_failures, copy.ecc_repairs);
+	}
+
+	shell_print(sh, "boot pass: %" PRIu32 " cycles, retention registers: %" PRIu32 " cycles, ecc repairs: %" PRIu32,
+		    boot->pass_cycles, boot->retain_cycles, ram_retained_ecc_repairs());
+
+	return 0;
+}
+
+#if defined(CONFIG_APP_RETENTION_DUMP)
+
+/* Frame bytes in one base64 line of "rr dump", a line is decoded on its own by "rr restore" */
+#define DUMP_LINE_BYTES 48
+
+struct dumpLine{
+	const struct shell *	sh;
+	uint8_t			buf[DUMP_LINE_BYTES];
+	size_t			len;
+};
+
+static uint8_t restore_buf[CONFIG_APP_RETENTION_DUMP_SHELL_BUF_SIZE] __aligned(4);
+static size_t restore_len;
+
+static void dump_line_flush(struct dumpLine *a_p_line)
+{
+	uint8_t out[((DUMP_LINE_BYTES + 2) / 3) * 4 + 1];
+	size_t olen;
+
+	(void)base64_encode(out, sizeof(out), &olen, a_p_line->buf, a_p_line->len);
+	shell_print(a_p_line->sh, "%s", (const char *)out);
+	a_p_line->len = 0;
+}
+
+static int dump_line_write(const void *a_p_data, size_t a_len, void *a_user_data)
+{
+	struct dumpLine *line = a_user_data;
+	const uint8_t *data = a_p_data;
+
+	while (a_len > 0U) {
+		size_t chunk = MIN(a_len, sizeof(line->buf) - line->len);
+
+		memcpy(line->buf + line->len, data, chunk);
+		line->len += chunk;
+		data += chunk;
+		a_len -= chunk;
+
+		if (line->len == sizeof(line->buf)) {
+			dump_line_flush(line);
+		}
+	}
+
+	return 0;
+}
+
+static int cmd_rr_dump(const struct shell *sh, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	struct dumpLine line = { .sh = sh, .len = 0 };
+
+	shell_print(sh, "RRDUMP %u", (unsigned int)ram_retained_dump_size());
+
+	int len = ram_retained_dump(dump_line_write, &line);
+
+	if (line.len != 0U) {
+		dump_line_flush(&line);
+	}
+	shell_print(sh, "RRDUMP END");
+
+	return (len < 0) ? len : 0;
+}
+
+static int cmd_rr_restore(const struct shell *sh, size_t argc, char **argv)
+{
+	if (argc == 1) {
+		restore_len = 0;
+		shell_print(sh, "restore buffer cleared");
+		return 0;
+	}
+
+	for (size_t i = 1; i < argc; i++) {
+		size_t olen;
+
+		if (base64_decode(restore_buf + restore_len, sizeof(restore_buf) - restore_len, &olen,
+				  (const uint8_t *)argv[i], strlen(argv[i])) != 0) {
+			shell_error(sh, "not a line of rr dump, or frame larger than %u bytes", (unsigned int)sizeof(restore_buf));
+			restore_len = 0;
+			return -EINVAL;
+		}
+		restore_len += olen;
+	}
+
+	if (restore_len < sizeof(struct ramRetDumpHeader)) {
+		return 0;
+	}
+
+	const struct ramRetDumpHeader *header = (const struct ramRetDumpHeader *)restore_buf;
+	size_t len = sys_le32_to_cpu(header->length);
+
+	if ((sys_le32_to_cpu(header->magic) != RR_DUMP_MAGIC) || (len > sizeof(restore_buf))) {
+		shell_error(sh, "not a ram retention frame, or frame larger than %u bytes", (unsigned int)sizeof(restore_buf));
+		restore_len = 0;
+		return -EINVAL;
+	}
+
+	if (restore_len < len) {
+		shell_print(sh, "%u/%u bytes", (unsigned int)restore_len, (unsigned int)len);
+		return 0;
+	}
+
+	int written = ram_retained_restore(restore_buf, restore_len);
+
+	restore_len = 0;
+	if (written < 0) {
+		shell_error(sh, "restore error %d", written);
+		return written;
+	}
+
+	shell_print(sh, "%d variables restored", written);
+
+	return 0;
+}
+
+#endif /* CONFIG_APP_RETENTION_DUMP */
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_rr,
+	SHELL_CMD(stats, NULL, "Cycle counts of validation and commits of ram retention variables", cmd_rr_stats),
+	SHELL_COND_CMD(CONFIG_APP_RETENTION_DUMP, dump, NULL,
+		       "Dump every registered variable as one base64 encoded frame", cmd_rr_dump),
+	SHELL_COND_CMD(CONFIG_APP_RETENTION_DUMP, restore, NULL,
+		       "Restore a frame given as the lines of rr dump, no argument clears a partly received frame", cmd_rr_restore),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(rr, &sub_rr, "Ram retention commands", NULL);
@@ -0,0 +1,208 @@
+/**
+ * @author Batto1
+ * @brief  Spill of ram retention variables to flash (CONFIG_APP_RETENTION_SPILL), see ram_retention_spill.h.
+ *         Every variable is one nvs_write() straight from retained RAM, NVS skips the write if the flash copy is already the same.
+ *         Power-fail warning only wakes the spill thread, flash is never written from the ISR.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/flash.h>
+#include <zephyr/fs/nvs.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/logging/log.h>
+
+#if defined(CONFIG_APP_RETENTION_SPILL_ON_POFWARN)
+#include <zephyr/init.h>
+#include <nrfx_power.h>
+#endif
+
+#include "ram_retention_utils.h"
+#include "ram_retention_spill.h"
+
+
+LOG_MODULE_DECLARE(ram_retention_utils, CONFIG_LOG_DEFAULT_LEVEL);
+
+
+#define SPILL_NODE		DT_CHOSEN(rr_spill_partition)
+#define SPILL_FLASH_DEV		DEVICE_DT_GET(DT_MTD_FROM_FIXED_PARTITION(SPILL_NODE))
+
+static struct nvs_fs spill_fs;
+static bool spill_mounted;
+
+
+
+/* Id of the variable folded to 16 bits */
+static uint16_t spill_id(const struct ramRetDescriptor *desc)
+{
+	uint32_t hash = ram_retained_desc_id(desc);
+
+	return (uint16_t)((hash >> 16) ^ hash);
+}
+
+/* Two variables with the same 16-bit id would restore each other's flash copy. */
+static int spill_check_ids(void)
+{
+	int err = 0;
+
+	STRUCT_SECTION_FOREACH(ramRetDescriptor, desc) {
+		STRUCT_SECTION_FOREACH(ramRetDescriptor, other) {
+			if ((other > desc) && (spill_id(desc) == spill_id(other))) {
+				LOG_ERR("Ram ret variables <%s> and <%s> have the same spill id 0x%04x",
+					desc->name, other->name, spill_id(desc));
+				err = -EEXIST;
+			}
+		}
+	}
+
+	return err;
+}
+
+int ram_retention_spill_mount(void)
+{
+	struct flash_pages_info info;
+	int err;
+
+	err = spill_check_ids();
+	if (err != 0) {
+		return err;
+	}
+
+	spill_fs.flash_device = SPILL_FLASH_DEV;
+	if (!device_is_ready(spill_fs.flash_device)) {
+		return -ENODEV;
+	}
+
+	spill_fs.offset = DT_REG_ADDR(SPILL_NODE);
+	err = flash_get_page_info_by_offs(spill_fs.flash_device, spill_fs.offset, &info);
+	if (err != 0) {
+		return err;
+	}
+
+	spill_fs.sector_size = info.size;
+	spill_fs.sector_count = DT_REG_SIZE(SPILL_NODE) / info.size;
+
+	err = nvs_mount(&spill_fs);
+	spill_mounted = (err == 0);
+
+	return err;
+}
+
+bool ram_retention_spill_restore(const struct ramRetDescriptor *a_desc)
+{
+	if (!spill_mounted) {
+		return false;
+	}
+
+	/* Length of the entry is returned even if it doesn't fit, a copy of another size belongs to an older layout. */
+	ssize_t len = nvs_read(&spill_fs, spill_id(a_desc), a_desc->addr, a_desc->size);
+
+	if (len != (ssize_t)a_desc->size) {
+		return false;
+	}
+
+	return ram_retained_check_integrity((enum ramRetIntegrity)a_desc->integrity, a_desc->addr, a_desc->crc_offset);
+}
+
+void ram_retained_spill_mark(const struct ramRetDescriptor *a_desc)
+{
+	atomic_set_bit(a_desc->state, RR_STATE_UNSAVED);
+}
+
+int ram_retained_spill(void)
+{
+	size_t budget = CONFIG_APP_RETENTION_SPILL_BUDGET;
+	int written = 0;
+
+	if (!spill_mounted) {
+		return -ENODEV;
+	}
+
+	STRUCT_SECTION_FOREACH(ramRetDescriptor, desc) {
+		if (!atomic_test_bit(desc->state, RR_STATE_UNSAVED) && !atomic_test_bit(desc->state, RR_STATE_DIRTY)) {
+			continue;
+		}
+
+		/* Smaller variables after it may still fit. */
+		if (desc->size > budget) {
+			continue;
+		}
+
+		/* Deferred commit, crc of the flash copy must be up to date. */
+		if (atomic_test_bit(desc->state, RR_STATE_DIRTY)) {
+			ram_retained_update_descs(desc, 1);
+		}
+
+		/* Cleared before the write, so a change racing with the write marks the variable again. */
+		atomic_clear_bit(desc->state, RR_STATE_UNSAVED);
+
+		ssize_t err = nvs_write(&spill_fs, spill_id(desc), desc->addr, desc->size);
+
+		if (err < 0) {
+			atomic_set_bit(desc->state, RR_STATE_UNSAVED);
+			return (int)err;
+		}
+
+		budget -= desc->size;
+		written++;
+	}
+
+	return written;
+}
+
+
+
+#if defined(CONFIG_APP_RETENTION_SPILL_ON_POFWARN)
+
+static K_SEM_DEFINE(spill_sem, 0, 1);
+
+static void ram_retention_pofwarn_handler(void)
+{
+	k_sem_give(&spill_sem);
+}
+
+/* Cooperative and of the highest priority, nothing preempts the spill except ISRs. */
+static void ram_retention_spill_thread(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (true) {
+		(void)k_sem_take(&spill_sem, K_FOREVER);
+
+		int written = ram_retained_spill();
+
+		if (written < 0) {
+			LOG_ERR("Ram ret spill error %d", written);
+		}
+	}
+}
+
+K_THREAD_DEFINE(ram_retention_spill_tid, CONFIG_APP_RETENTION_SPILL_STACK_SIZE, ram_retention_spill_thread,
+		NULL, NULL, NULL, K_PRIO_COOP(0), 0, 0);
+
+static const nrfx_power_pofwarn_config_t pofwarn_config = {
+	.handler	= ram_retention_pofwarn_handler,
+	.thr		= UTIL_CAT(NRF_POWER_POFTHR_V, CONFIG_APP_RETENTION_SPILL_POF_THRESHOLD),
+};
+
+/* After the boot pass, variables restored from flash don't have to be written back. */
+static int ram_retention_spill_pof_init(const struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	if (nrfx_power_pof_init(&pofwarn_config) != NRFX_SUCCESS) {
+		LOG_ERR("Ram ret power-fail warning isn't available");
+		return 0;
+	}
+
+	nrfx_power_pof_enable(&pofwarn_config);
+
+	return 0;
+}
+
+SYS_INIT(ram_retention_spill_pof_init, APPLICATION, 31);
+
+#endif /* CONFIG_APP_RETENTION_SPILL_ON_POFWARN */
@@ -0,0 +1,64 @@
+/**
+ * @author Batto1
+ * @brief  Spill of ram retention variables to flash (CONFIG_APP_RETENTION_SPILL), so that they also survive a power loss.
+ *         Variables defined with RR_Init_Var_Ram_Retention() that are changed since their last spill are written to an NVS file system,
+ *         one NVS entry per variable streamed directly from retained RAM. When a variable isn't valid at boot (i.e. after a power loss),
+ *         its flash copy is restored instead of its default value, if the copy passes the integrity check of the variable.
+ *         Only the init pass reads flash: a lazy variable is restored after a power-on reset, but a lazy variable found invalid
+ *         at its first access is reset to its default value.
+ *         With CONFIG_APP_RETENTION_SPILL_ON_POFWARN the spill runs when the nRF52 POWER peripheral signals the power-fail warning.
+ * @note   Flash partition is the devicetree fixed partition chosen with "rr,spill-partition". NVS entry of a variable is identified by a
+ *         16-bit hash of its name, so variables keep their flash copy when other variables are added or removed. The file system
+ *         isn't mounted if two variables have the same hash, rename one of them.
+ * @note   Only commits through the descriptor of a variable mark it as changed, i.e. RR_Var_Ram_Ret_Defer(), RR_Var_Ram_Ret_Many() and
+ *         ram_retained_flush(). A variable changed with RR_Var_Ram_Ret() or RR_Var_Ram_Ret_Field() must be marked with RR_Var_Spill_Mark().
+ */
+
+#ifndef RAM_RETENTION_SPILL_H
+#define RAM_RETENTION_SPILL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+#include "ram_retention_utils.h"
+
+
+/**
+ * @brief Write every variable changed since its last spill to flash, at most CONFIG_APP_RETENTION_SPILL_BUDGET bytes.
+ *        Variables that don't fit in the budget stay marked and are written by the next spill. A dirty variable of the deferred commit
+ *        mode is committed before it is written.
+ * @note  Blocks on flash writes, mustn't be called from an ISR. Can be called any time, i.e. before a planned power off.
+ * @return number of variables written, -ENODEV if the file system isn't mounted or a negative NVS error.
+*/
+int ram_retained_spill(void);
+
+/**
+ * @brief Mark a registered variable as changed, so that it is written by the next spill.
+ * @param [in] a_desc descriptor of the variable
+*/
+void ram_retained_spill_mark(const struct ramRetDescriptor *a_desc);
+
+/**
+ * @brief Mark a variable defined with RR_Init_Var_Ram_Retention() as changed, see ram_retained_spill_mark().
+*/
+#define RR_Var_Spill_Mark(rr_var_name) ram_retained_spill_mark(&_rr_desc_##rr_var_name)
+
+/**
+ * @brief INTERNAL. Hooks of the boot pass, defined in ram_retention_spill.c.
+ * @note  ram_retention_spill_mount() mounts the file system, -EEXIST if two variables have the same NVS id.
+ *        ram_retention_spill_restore() copies the flash copy of a variable into it and returns true if the restored variable is valid.
+*/
+int ram_retention_spill_mount(void);
+bool ram_retention_spill_restore(const struct ramRetDescriptor *a_desc);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RAM_RETENTION_SPILL_H */
@@ -10,38 +10,52 @@
 #include <zephyr/devicetree.h>
 #include <zephyr/sys/byteorder.h>
 #include <zephyr/sys/crc.h>
-#include <hal/nrf_power.h>
+#include <zephyr/logging/log.h>
+
+#if defined(CONFIG_APP_RETENTION_STATS)
+#include <zephyr/arch/arm/aarch32/cortex_m/cmsis.h>
+#endif
 
 #include "ram_retention_utils.h"
+#include "ram_retention_crc.h"
+#include "ram_retention_hal.h"
+
+#if defined(CONFIG_APP_RETENTION_SPILL)
+#include "ram_retention_spill.h"
+#endif
 
 
+LOG_MODULE_REGISTER(ram_retention_utils, CONFIG_LOG_DEFAULT_LEVEL);
 
-/* nRF52 RAM (really, RAM AHB slaves) are partitioned as:
+
+/* RAM (really, RAM AHB slaves) is partitioned by the backend, see
+ * ram_retention_hal.h.  On nRF52:
  * * Up to 8 blocks of two 4 KiBy byte "small" sections
  * * A 9th block of with 32 KiBy "large" sections
  *
  * At time of writing the maximum number of large sections is 6, all
  * within the first large block.  Theoretically there could be more
  * sections in the 9th block, and possibly more blocks.
+ * Other backends have no large block.
  */
 
 /* Inclusive address of RAM start */
-#define SRAM_BEGIN (uintptr_t)DT_REG_ADDR(DT_NODELABEL(sram0))
+#define SRAM_BEGIN RR_HAL_SRAM_BEGIN
 
 /* Exclusive address of RAM end */
-#define SRAM_END (SRAM_BEGIN + (uintptr_t)DT_REG_SIZE(DT_NODELABEL(sram0)))
+#define SRAM_END (SRAM_BEGIN + RR_HAL_SRAM_SIZE)
 
 /* Size of a controllable RAM section in the small blocks */
-#define SMALL_SECTION_SIZE 4096
+#define SMALL_SECTION_SIZE RR_HAL_SMALL_SECTION_SIZE
 
 /* Number of controllable RAM sections in each of the lower blocks */
-#define SMALL_SECTIONS_PER_BLOCK 2
+#define SMALL_SECTIONS_PER_BLOCK RR_HAL_SMALL_SECTIONS_PER_BLOCK
 
 /* Span of a small block */
 #define SMALL_BLOCK_SIZE (SMALL_SECTIONS_PER_BLOCK * SMALL_SECTION_SIZE)
 
 /* Number of small blocks */
-#define SMALL_BLOCK_COUNT 8
+#define SMALL_BLOCK_COUNT RR_HAL_SMALL_BLOCK_COUNT
 
 /* Span of the SRAM area covered by small sections */
 #define SMALL_SECTION_SPAN (SMALL_BLOCK_COUNT * SMALL_BLOCK_SIZE)
@@ -50,7 +64,78 @@
 #define LARGE_SECTION_BEGIN (SRAM_BEGIN + SMALL_SECTION_SPAN)
 
 /* Size of a controllable RAM section in large blocks */
-#define LARGE_SECTION_SIZE 32768
+#define LARGE_SECTION_SIZE RR_HAL_LARGE_SECTION_SIZE
+
+/* Maximum number of controllable RAM sections in the large block, 0 if there is no large block */
+#define LARGE_SECTIONS_PER_BLOCK RR_HAL_LARGE_SECTIONS_PER_BLOCK
+
+/* Retention bit of section n of a block is RETENTION_POS + n */
+#define RETENTION_POS RR_HAL_RETENTION_POS
+
+BUILD_ASSERT(RR_RAM_BLOCK_COUNT == (SMALL_BLOCK_COUNT + ((LARGE_SECTIONS_PER_BLOCK != 0) ? 1 : 0)),
+	     "RAM block count mismatch");
+
+/* Slots of types with a layout header must be the largest alignment of the ".ram_retained" section, see ram_retention_noinit.ld */
+BUILD_ASSERT((CONFIG_APP_RETENTION_LAYOUT_SLOT_SIZE & (CONFIG_APP_RETENTION_LAYOUT_SLOT_SIZE - 1)) == 0,
+	     "CONFIG_APP_RETENTION_LAYOUT_SLOT_SIZE must be a power of two");
+
+/* The residue of a CRC is what you get from the CRC over the
+ * message catenated with its CRC.  This is the post-final-xor
+ * residue for CRC-32 (CRC-32/ISO-HDLC) which Zephyr calls
+ * crc32_ieee.  Every CONFIG_APP_RETENTION_CRC32 implementation
+ * gives the same residue.
+ */
+#define RETAINED_CRC_RESIDUE 0x2144df1c
+
+/* Reset reason of the backend as read at the first call of ram_retention_reset_reason() */
+static uint32_t reset_reason;
+static atomic_t reset_reason_read;
+
+uint32_t ram_retention_reset_reason(void)
+{
+	/* Init levels are single threaded, a concurrent first call isn't expected. */
+	if (!atomic_test_and_set_bit(&reset_reason_read, 0)) {
+		reset_reason = rr_hal_reset_reason();
+	}
+
+	return reset_reason;
+}
+
+bool ram_retention_is_cold_boot(void)
+{
+	/* RESETREAS is cleared by power-on and brown-out resets only, and no
+	 * bit is set for them.
+	 */
+	return (ram_retention_reset_reason() == 0U);
+}
+
+/* Set at the end of the boot pass, validation is skipped only by the init functions before it. */
+static bool init_pass_done;
+
+/* true if retained variables are reset without checking them */
+static inline bool ram_retention_skip_validation(void)
+{
+	return IS_ENABLED(CONFIG_APP_RETENTION_SKIP_ON_COLD_BOOT) && !init_pass_done && ram_retention_is_cold_boot();
+}
+
+/* Bounds of the ".ram_retained" linker section, see ram_retention_noinit.ld */
+extern char __ram_retained_start[];
+extern char __ram_retained_end[];
+
+/* Retention masks of the ".ram_retained" section for each RAM block,
+ * computed at link time for the nRF52 POWER backend, see
+ * ram_retention_masks.ld.  Only the symbol values are used, they aren't
+ * objects.
+ */
+extern char __ram_retained_mask_0[];
+extern char __ram_retained_mask_1[];
+extern char __ram_retained_mask_2[];
+extern char __ram_retained_mask_3[];
+extern char __ram_retained_mask_4[];
+extern char __ram_retained_mask_5[];
+extern char __ram_retained_mask_6[];
+extern char __ram_retained_mask_7[];
+extern char __ram_retained_mask_8[];
 
 
 
@@ -71,16 +156,9 @@ bool RR_Init_Variable_Ram_Retention(void * a_retained_var_ptr, size_t a_retained
 */
 bool ram_retained_validate(void * a_retained_var_ptr, size_t a_retained_var_size, size_t a_retained_crc_offset, size_t a_sizeof_retained_crc)
 {
-	/* The residue of a CRC is what you get from the CRC over the
-	 * message catenated with its CRC.  This is the post-final-xor
-	 * residue for CRC-32 (CRC-32/ISO-HDLC) which Zephyr calls
-	 * crc32_ieee.
-	 */
-	const uint32_t residue = 0x2144df1c;
      size_t retained_checked_size = a_retained_crc_offset + a_sizeof_retained_crc;
-	uint32_t crc = crc32_ieee((const uint8_t *)a_retained_var_ptr, retained_checked_size);
+	bool valid = ram_retained_check(a_retained_var_ptr, retained_checked_size);
 	
-	bool valid = (crc == residue);
 	/* If the CRC isn't valid, reset the retained data. */
 	if (!valid) {
 		memset(a_retained_var_ptr, 0, a_retained_var_size);
@@ -97,94 +175,1284 @@ bool ram_retained_validate(void * a_retained_var_ptr, size_t a_retained_var_size
 	return valid;
 }
 
+/*
+ * @brief check the CRC of the retained variable without modifying it.
+ * @param [in] a_retained_var_ptr 	pointer to the ram retained variable
+ * @param [in] a_checked_size 		size of the checked area, including the crc variable at its end.
+ * @return true if valid, false if not.
+ */
+bool ram_retained_check(const void * a_retained_var_ptr, size_t a_checked_size)
+{
+	uint32_t crc = ram_retention_crc32((const uint8_t *)a_retained_var_ptr, a_checked_size);
+
+	return (crc == RETAINED_CRC_RESIDUE);
+}
+
 /*
  * @brief update the retained variable.
  */
 void ram_retained_update(void * a_p_retained_var, size_t a_retained_crc_offset)
 {
-	uint32_t crc = crc32_ieee((const uint8_t *)a_p_retained_var, a_retained_crc_offset);
+	uint32_t crc = ram_retention_crc32((const uint8_t *)a_p_retained_var, a_retained_crc_offset);
 
-     uint32_t* crc_ptr = (uint32_t*)((char*)a_p_retained_var + a_retained_crc_offset);
-     * crc_ptr = sys_cpu_to_le32(crc);
+	/* crc variable isn't aligned in packed types, see RamRetTypeDeclareGroup() */
+	sys_put_le32(crc, (uint8_t *)a_p_retained_var + a_retained_crc_offset);
 }
 
-/* Set or clear RAM retention in SYSTEM_OFF for the provided object.
- *
- * @note This only works for nRF52 with the POWER module.  The other
- * Nordic chips use a different low-level API, which is not currently
- * used by this function.
- *
- * @param ptr pointer to the start of the retainable object
- *
- * @param len length of the retainable object
- *
- * @param enable true to enable retention, false to clear retention
+/* Size of the buffer the changed bits of a field are collected in */
+#define FIELD_DELTA_CHUNK_SIZE 16
+
+/*
+ * @brief write one field of a CRC-32 checked retained variable and patch its CRC incrementally.
+ *        CRC-32 is linear, so the CRC is patched with the CRC of the changed bits, shifted over the bytes after the field.
+ *        Cost depends on the field size (and logarithmically on the distance to the crc variable), not on the size of the variable.
+ * @note  CRC of the variable must be valid before the call, otherwise it stays invalid.
+ * @param [in] a_p_retained_var 	pointer to the ram retained variable
+ * @param [in] a_retained_crc_offset 	ram retention type variable's crc offset.
+ * @param [in] a_field_offset 		offset of the field from the start of the ram retained variable
+ * @param [in] a_p_new_value 		pointer to the new value of the field
+ * @param [in] a_field_size 		size of the field
  */
-int ram_range_retain(const void *ptr,
-			    size_t len,
-			    bool enable)
+void ram_retained_update_field(void * a_p_retained_var, size_t a_retained_crc_offset, size_t a_field_offset, const void * a_p_new_value, size_t a_field_size)
 {
-	uintptr_t addr = (uintptr_t)ptr;
-	uintptr_t addr_end = addr + len;
+	__ASSERT_NO_MSG((a_field_offset + a_field_size) <= a_retained_crc_offset);
 
-	/* Error if the provided range is empty or doesn't lie
-	 * entirely within the SRAM address space.
-	 */
-	if ((len == 0U)
-	    || (addr < SRAM_BEGIN)
-	    || (addr > (SRAM_END - len))) {
-		return -EINVAL;
+	uint8_t *field = (uint8_t *)a_p_retained_var + a_field_offset;
+	const uint8_t *new_value = (const uint8_t *)a_p_new_value;
+	uint8_t delta[FIELD_DELTA_CHUNK_SIZE];
+	uint32_t raw = 0;
+
+	for (size_t done = 0; done < a_field_size; ) {
+		size_t chunk = MIN(sizeof(delta), a_field_size - done);
+
+		for (size_t i = 0; i < chunk; i++) {
+			delta[i] = field[done + i] ^ new_value[done + i];
+			field[done + i] = new_value[done + i];
+		}
+		raw = ram_retention_crc32_raw(raw, delta, chunk);
+		done += chunk;
 	}
 
-	/* Iterate over each section covered by the range, setting the
-	 * corresponding RAM OFF retention bit in the parent block.
-	 */
+	raw = ram_retention_crc32_shift(raw, a_retained_crc_offset - a_field_offset - a_field_size);
+
+	uint8_t *crc_ptr = (uint8_t *)a_p_retained_var + a_retained_crc_offset;
+
+	sys_put_le32(sys_get_le32(crc_ptr) ^ raw, crc_ptr);
+}
+
+/*
+ * @brief set or clear the bits of one word of a CRC-32 checked retained variable atomically and patch its CRC.
+ *        Only the changed bits are CRCed and shifted to the crc variable. XOR patches commute, so concurrent
+ *        updates of other bits (i.e. from ISRs) keep the CRC valid without a lock.
+ * @note  A reset between the bit update and the CRC patch leaves the variable invalid.
+ * @param [in] a_p_retained_var 	pointer to the ram retained variable
+ * @param [in] a_word_offset 		offset of the atomic_t word
+ * @param [in] a_mask 			bits to be set or cleared
+ * @param [in] a_set 			true to set, false to clear
+ * @param [in] a_retained_crc_offset 	ram retention type variable's atomic_t crc offset.
+ */
+static void ram_retained_bits_apply(void * a_p_retained_var, size_t a_word_offset, atomic_val_t a_mask, bool a_set, size_t a_retained_crc_offset)
+{
+	uint8_t *var = (uint8_t *)a_p_retained_var;
+	atomic_t *word = (atomic_t *)(var + a_word_offset);
+	atomic_val_t changed;
+
+	if (a_set) {
+		changed = a_mask & ~atomic_or(word, a_mask);
+	} else {
+		changed = a_mask & atomic_and(word, ~a_mask);
+	}
+
+	if (changed == 0) {
+		return;
+	}
+
+	uint32_t raw = ram_retention_crc32_raw(0, (const uint8_t *)&changed, sizeof(changed));
+
+	raw = ram_retention_crc32_shift(raw, a_retained_crc_offset - a_word_offset - sizeof(atomic_t));
+
+	(void)atomic_xor((atomic_t *)(var + a_retained_crc_offset), (atomic_val_t)sys_cpu_to_le32(raw));
+}
+
+/*
+ * @brief set a flag of a retained bitset declared with RamRetTypeDeclareBitset() and mark it configured.
+ * @param [in] a_p_retained_var 	pointer to the ram retained variable
+ * @param [in] a_configured_offset 	offset of rr_configured, rr_bits is at the start
+ * @param [in] a_retained_crc_offset 	ram retention type variable's crc offset.
+ * @param [in] a_bit 			index of the flag
+ * @param [in] a_value 			new value of the flag
+ */
+void ram_retained_bitset_set(void * a_p_retained_var, size_t a_configured_offset, size_t a_retained_crc_offset, size_t a_bit, bool a_value)
+{
+	size_t word_offset = (a_bit / ATOMIC_BITS) * sizeof(atomic_t);
+
+	__ASSERT_NO_MSG(word_offset < a_configured_offset);
+
+	ram_retained_bits_apply(a_p_retained_var, word_offset, ATOMIC_MASK(a_bit), a_value, a_retained_crc_offset);
+	ram_retained_bits_apply(a_p_retained_var, a_configured_offset + word_offset, ATOMIC_MASK(a_bit), true, a_retained_crc_offset);
+}
+
+/*
+ * @brief return a flag of a retained bitset declared with RamRetTypeDeclareBitset() to its default value.
+ */
+void ram_retained_bitset_unset(void * a_p_retained_var, size_t a_configured_offset, size_t a_retained_crc_offset, size_t a_bit)
+{
+	size_t word_offset = (a_bit / ATOMIC_BITS) * sizeof(atomic_t);
+
+	__ASSERT_NO_MSG(word_offset < a_configured_offset);
+
+	ram_retained_bits_apply(a_p_retained_var, a_configured_offset + word_offset, ATOMIC_MASK(a_bit), false, a_retained_crc_offset);
+	ram_retained_bits_apply(a_p_retained_var, word_offset, ATOMIC_MASK(a_bit), false, a_retained_crc_offset);
+}
+
+/*
+ * @brief seqlock write of a retained variable declared with RamRetTypeDeclareSeq().
+ *        Sequence counter is odd while a write is in progress. Writer claims the variable by moving it from even to odd,
+ *        so a second writer (i.e. an ISR preempting the first one) fails instead of interleaving its writes.
+ * @note  CRC is computed for the final, even sequence counter before it is published, so the variable is valid
+ *        at reset only when no write is in progress.
+ * @param [in] a_p_retained_var 	pointer to the ram retained variable
+ * @param [in] a_var_offset 		offset of rr_var
+ * @param [in] a_p_value 		pointer to the new value
+ * @param [in] a_var_size 		size of rr_var
+ * @param [in] a_retained_crc_offset 	ram retention type variable's crc offset.
+ * @return 0 on success, -EBUSY if another write is in progress.
+ */
+int ram_retained_seq_write(void * a_p_retained_var, size_t a_var_offset, const void * a_p_value, size_t a_var_size, size_t a_retained_crc_offset)
+{
+	atomic_t *seq = (atomic_t *)a_p_retained_var;
+	atomic_val_t current = atomic_get(seq);
+
+	if (((current & 1) != 0) || !atomic_cas(seq, current, current + 1)) {
+		return -EBUSY;
+	}
+
+	memcpy((uint8_t *)a_p_retained_var + a_var_offset, a_p_value, a_var_size);
+
+	atomic_val_t next = current + 2;
+	uint32_t crc = ram_retention_crc32((const uint8_t *)&next, sizeof(next));
+
+	crc = ram_retention_crc32_update(crc, (const uint8_t *)a_p_retained_var + sizeof(atomic_t),
+					 a_retained_crc_offset - sizeof(atomic_t));
+
+	sys_put_le32(crc, (uint8_t *)a_p_retained_var + a_retained_crc_offset);
+
+	(void)atomic_set(seq, next);
+
+	return 0;
+}
+
+/*
+ * @brief seqlock read of a retained variable declared with RamRetTypeDeclareSeq().
+ *        Copy is retried only if a write completed during the copy, so the read is lock-free.
+ * @param [in]  a_p_retained_var 	pointer to the ram retained variable
+ * @param [in]  a_var_offset 		offset of rr_var
+ * @param [out] a_p_value 		pointer to the copy
+ * @param [in]  a_var_size 		size of rr_var
+ * @return 0 on success, -EBUSY if a write is in progress.
+ */
+int ram_retained_seq_read(const void * a_p_retained_var, size_t a_var_offset, void * a_p_value, size_t a_var_size)
+{
+	const atomic_t *seq = (const atomic_t *)a_p_retained_var;
+	atomic_val_t before;
+
 	do {
-		uintptr_t block_base = SRAM_BEGIN;
-		uint32_t section_size = SMALL_SECTION_SIZE;
-		uint32_t sections_per_block = SMALL_SECTIONS_PER_BLOCK;
-		bool is_large = (addr >= LARGE_SECTION_BEGIN);
-		uint8_t block = 0;
+		before = atomic_get(seq);
+		if ((before & 1) != 0) {
+			return -EBUSY;
+		}
+
+		memcpy(a_p_value, (const uint8_t *)a_p_retained_var + a_var_offset, a_var_size);
+		compiler_barrier();
+	} while (atomic_get(seq) != before);
+
+	return 0;
+}
+
+/*
+ * @brief check the CRC-16 of the retained variable without modifying it.
+ * @param [in] a_retained_var_ptr 	pointer to the ram retained variable
+ * @param [in] a_retained_crc_offset 	ram retention type variable's uint16_t crc offset.
+ * @return true if valid, false if not.
+ */
+bool ram_retained_check_crc16(const void * a_retained_var_ptr, size_t a_retained_crc_offset)
+{
+	uint16_t crc = crc16_ccitt(0xFFFF, (const uint8_t *)a_retained_var_ptr, a_retained_crc_offset);
+
+	return (crc == sys_get_le16((const uint8_t *)a_retained_var_ptr + a_retained_crc_offset));
+}
+
+/*
+ * @brief update the retained variable checked with CRC-16.
+ */
+void ram_retained_update_crc16(void * a_p_retained_var, size_t a_retained_crc_offset)
+{
+	uint16_t crc = crc16_ccitt(0xFFFF, (const uint8_t *)a_p_retained_var, a_retained_crc_offset);
+
+	sys_put_le16(crc, (uint8_t *)a_p_retained_var + a_retained_crc_offset);
+}
+
+/*
+ * @brief check the Fletcher-32 of the retained variable without modifying it.
+ * @param [in] a_retained_var_ptr 	pointer to the ram retained variable
+ * @param [in] a_retained_crc_offset 	ram retention type variable's uint32_t crc offset.
+ * @return true if valid, false if not.
+ */
+bool ram_retained_check_fletcher32(const void * a_retained_var_ptr, size_t a_retained_crc_offset)
+{
+	uint32_t sum = ram_retention_fletcher32((const uint8_t *)a_retained_var_ptr, a_retained_crc_offset);
+
+	return (sum == sys_get_le32((const uint8_t *)a_retained_var_ptr + a_retained_crc_offset));
+}
+
+/*
+ * @brief update the retained variable checked with Fletcher-32.
+ */
+void ram_retained_update_fletcher32(void * a_p_retained_var, size_t a_retained_crc_offset)
+{
+	uint32_t sum = ram_retention_fletcher32((const uint8_t *)a_p_retained_var, a_retained_crc_offset);
+
+	sys_put_le32(sum, (uint8_t *)a_p_retained_var + a_retained_crc_offset);
+}
+
+/*
+ * @brief check the inverted copy of the 32-bit retained variable without modifying it.
+ * @param [in] a_retained_var_ptr 	pointer to the ram retained variable
+ * @param [in] a_retained_crc_offset 	ram retention type variable's atomic_t crc offset.
+ * @return true if valid, false if not.
+ */
+bool ram_retained_check_inverted(const void * a_retained_var_ptr, size_t a_retained_crc_offset)
+{
+	__ASSERT_NO_MSG(a_retained_crc_offset == sizeof(atomic_t));
+
+	const atomic_t *value = (const atomic_t *)a_retained_var_ptr;
+	const atomic_t *check = (const atomic_t *)((const uint8_t *)a_retained_var_ptr + a_retained_crc_offset);
+
+	return (atomic_get(check) == ~atomic_get(value));
+}
+
+/*
+ * @brief update the retained variable checked with its inverted copy.
+ */
+void ram_retained_update_inverted(void * a_p_retained_var, size_t a_retained_crc_offset)
+{
+	__ASSERT_NO_MSG(a_retained_crc_offset == sizeof(atomic_t));
+
+	_rr_atomic_check_update((RamRetAtomicInv *)a_p_retained_var);
+}
+
+/* Number of variables repaired by ram_retained_recover_ecc() since boot */
+static atomic_t ecc_repairs;
+
+/* XOR of the little endian 32-bit words of the data, len is a multiple of 4 */
+static uint32_t ram_retained_ecc_parity(const uint8_t * a_p_data, size_t a_len)
+{
+	uint32_t parity = 0;
+
+	for (size_t i = 0; i < a_len; i += sizeof(uint32_t)) {
+		parity ^= sys_get_le32(a_p_data + i);
+	}
+
+	return parity;
+}
+
+/*
+ * @brief update the retained variable checked with CRC-32 and its parity word.
+ */
+void ram_retained_update_ecc(void * a_p_retained_var, size_t a_retained_crc_offset)
+{
+	uint8_t *var = (uint8_t *)a_p_retained_var;
+
+	__ASSERT_NO_MSG((a_retained_crc_offset % sizeof(uint32_t)) == 0U);
 
-		if (is_large) {
-			block = 8;
-			block_base = LARGE_SECTION_BEGIN;
-			section_size = LARGE_SECTION_SIZE;
+	ram_retained_update(var, a_retained_crc_offset);
+	sys_put_le32(ram_retained_ecc_parity(var, a_retained_crc_offset), var + a_retained_crc_offset + sizeof(uint32_t));
+}
+
+/*
+ * @brief check the retained variable checked with CRC-32 and its parity word, repair it if the error lies within one 32-bit word.
+ *        Parity syndrome is the error pattern of the corrupted word. CRC-32 is linear, so flipping the syndrome in word k changes the
+ *        CRC by the linear CRC of the syndrome shifted over the bytes after word k: the word whose shifted CRC equals the CRC difference
+ *        is the corrupted one. Words are walked from the crc variable backwards, one 4 byte shift per word.
+ * @note  Repair is refused if more than one word explains the CRC difference, or if only the crc word differs, since the same parity
+ *        results from identical errors in two data words. Cost is only paid when the CRC doesn't match.
+ * @param [in] a_p_retained_var 	pointer to the ram retained variable
+ * @param [in] a_retained_crc_offset 	ram retention type variable's crc offset.
+ * @return 0 if valid, 1 if repaired, -EBADMSG if it can't be repaired.
+ */
+int ram_retained_recover_ecc(void * a_p_retained_var, size_t a_retained_crc_offset)
+{
+	uint8_t *var = (uint8_t *)a_p_retained_var;
+	uint8_t *crc_ptr = var + a_retained_crc_offset;
+	uint8_t *parity_ptr = crc_ptr + sizeof(uint32_t);
+	uint32_t crc = ram_retention_crc32(var, a_retained_crc_offset);
+	uint32_t parity = ram_retained_ecc_parity(var, a_retained_crc_offset);
+	uint32_t delta = crc ^ sys_get_le32(crc_ptr);
+	uint32_t syndrome = parity ^ sys_get_le32(parity_ptr);
+
+	if ((delta == 0U) && (syndrome == 0U)) {
+		return 0;
+	}
+
+	/* Data matches its CRC, only the parity word is corrupted. */
+	if (delta == 0U) {
+		sys_put_le32(parity, parity_ptr);
+		return 1;
+	}
+
+	/* Parity matches but the CRC doesn't: either the crc word is corrupted or the same bits flipped in an even number of
+	 * data words, which can't be told apart. The data isn't proven intact, so it isn't repaired.
+	 */
+	if (syndrome == 0U) {
+		return -EBADMSG;
+	}
+
+	uint8_t pattern[sizeof(uint32_t)];
+	size_t found = a_retained_crc_offset;
+
+	sys_put_le32(syndrome, pattern);
+
+	uint32_t raw = ram_retention_crc32_raw(0U, pattern, sizeof(pattern));
+
+	for (size_t pos = a_retained_crc_offset; pos > 0U; ) {
+		pos -= sizeof(uint32_t);
 
-			/* RAM[x] supports only 16 sections, each its own bit
-			 * for POWER (0..15) and RETENTION (16..31).  We don't
-			 * know directly how many sections are present, so
-			 * assume they all are; the true limit will be
-			 * determined by the SRAM size.
-			 */
-			sections_per_block = 16;
+		if (raw == delta) {
+			if (found != a_retained_crc_offset) {
+				return -EBADMSG;
+			}
+			found = pos;
 		}
+		raw = ram_retention_crc32_shift(raw, sizeof(uint32_t));
+	}
+
+	if (found == a_retained_crc_offset) {
+		return -EBADMSG;
+	}
+
+	sys_put_le32(sys_get_le32(var + found) ^ syndrome, var + found);
+
+	return 1;
+}
+
+uint32_t ram_retained_ecc_repairs(void)
+{
+	return (uint32_t)atomic_get(&ecc_repairs);
+}
+
+/* Slot i of a ram retention variable declared with RamRetTypeDeclareAB() or RamRetTypeDeclareRing() */
+#define SLOT(var, slot_size, i) ((uint8_t *)(var) + ((i) * (slot_size)))
+
+/* Sequence number of a slot */
+#define SLOT_SEQ(slot) (&((struct ramRetSlotHeader *)(slot))->rr_seq)
+
+/* true if sequence number a is newer than b, sequence numbers wrap around */
+#define SEQ_NEWER(a, b) ((int32_t)((uint32_t)(a) - (uint32_t)(b)) > 0)
+
+/* CRC of a slot as it is with sequence number seq, covers everything after the crc variable */
+static uint32_t ram_retained_slot_crc(const uint8_t * a_p_slot, atomic_val_t a_seq, size_t a_slot_size)
+{
+	uint32_t crc = ram_retention_crc32((const uint8_t *)&a_seq, sizeof(a_seq));
+
+	return ram_retention_crc32_update(crc, a_p_slot + sizeof(struct ramRetSlotHeader),
+					  a_slot_size - sizeof(struct ramRetSlotHeader));
+}
 
-		uint32_t section = (addr - block_base) / section_size;
+/* A slot is valid if it is complete (even sequence number) and its CRC matches */
+static bool ram_retained_ab_slot_check(const uint8_t * a_p_slot, size_t a_slot_size)
+{
+	atomic_val_t seq = atomic_get(SLOT_SEQ(a_p_slot));
+	const struct ramRetSlotHeader *hdr = (const struct ramRetSlotHeader *)a_p_slot;
+
+	return (((seq & 1) == 0) &&
+		(ram_retained_slot_crc(a_p_slot, seq, a_slot_size) == sys_le32_to_cpu(hdr->crc)));
+}
+
+/* Index of the active slot for the given sequence numbers, a slot that is being written is never active. */
+static inline size_t ram_retained_ab_active(atomic_val_t a_seq0, atomic_val_t a_seq1)
+{
+	if ((a_seq1 & 1) != 0) {
+		return 0;
+	}
+	if ((a_seq0 & 1) != 0) {
+		return 1;
+	}
+	return SEQ_NEWER(a_seq1, a_seq0) ? 1 : 0;
+}
 
-		if (section >= sections_per_block) {
-			block += section / sections_per_block;
-			section %= sections_per_block;
+/*
+ * @brief write the inactive slot of a retained variable declared with RamRetTypeDeclareAB() and publish it.
+ *        Writer claims the inactive slot by moving its sequence number to the odd number after the active one,
+ *        so a second writer (i.e. an ISR preempting the first one) fails instead of interleaving its writes.
+ * @note  CRC is computed for the final, even sequence number before it is published. If a reset interrupts the write,
+ *        the slot is invalid at boot and the previous value in the other slot is used.
+ * @param [in] a_p_retained_var 	pointer to the ram retained variable
+ * @param [in] a_var_offset 		offset of rr_var in a slot
+ * @param [in] a_p_value 		pointer to the new value
+ * @param [in] a_var_size 		size of rr_var
+ * @param [in] a_slot_size 		size of a slot
+ * @return 0 on success, -EBUSY if another write is in progress.
+ */
+int ram_retained_ab_write(void * a_p_retained_var, size_t a_var_offset, const void * a_p_value, size_t a_var_size, size_t a_slot_size)
+{
+	atomic_t *seq0 = SLOT_SEQ(SLOT(a_p_retained_var, a_slot_size, 0));
+	atomic_t *seq1 = SLOT_SEQ(SLOT(a_p_retained_var, a_slot_size, 1));
+	atomic_val_t active_seq;
+	atomic_val_t inactive_seq;
+	size_t inactive;
+
+	/* CAS fails only if a complete write of the same slot preempted us, then the active slot is read again. */
+	do {
+		atomic_val_t s0 = atomic_get(seq0);
+		atomic_val_t s1 = atomic_get(seq1);
+
+		if (((s0 | s1) & 1) != 0) {
+			return -EBUSY;
 		}
 
-		uint32_t section_mask =
-			(POWER_RAM_POWERSET_S0RETENTION_On
-					 << (section + POWER_RAM_POWERSET_S0RETENTION_Pos));
+		inactive = 1 - ram_retained_ab_active(s0, s1);
+		active_seq = (inactive == 0) ? s1 : s0;
+		inactive_seq = (inactive == 0) ? s0 : s1;
+	} while (!atomic_cas((inactive == 0) ? seq0 : seq1, inactive_seq, active_seq + 1));
 
-		if (enable) {
-			nrf_power_rampower_mask_on(NRF_POWER, block, section_mask);
-		} else {
-			nrf_power_rampower_mask_off(NRF_POWER, block, section_mask);
+	uint8_t *slot = SLOT(a_p_retained_var, a_slot_size, inactive);
+	atomic_val_t next = active_seq + 2;
+
+	memcpy(slot + a_var_offset, a_p_value, a_var_size);
+
+	((struct ramRetSlotHeader *)slot)->crc = sys_cpu_to_le32(ram_retained_slot_crc(slot, next, a_slot_size));
+
+	(void)atomic_set(SLOT_SEQ(slot), next);
+
+	return 0;
+}
+
+/*
+ * @brief read the active slot of a retained variable declared with RamRetTypeDeclareAB().
+ *        Copy is retried only if the slot was claimed by a writer during the copy, so the read is lock-free.
+ * @param [in]  a_p_retained_var 	pointer to the ram retained variable
+ * @param [in]  a_var_offset 		offset of rr_var in a slot
+ * @param [out] a_p_value 		pointer to the copy
+ * @param [in]  a_var_size 		size of rr_var
+ * @param [in]  a_slot_size 		size of a slot
+ */
+void ram_retained_ab_read(const void * a_p_retained_var, size_t a_var_offset, void * a_p_value, size_t a_var_size, size_t a_slot_size)
+{
+	const uint8_t *var = (const uint8_t *)a_p_retained_var;
+	const atomic_t *seq;
+	atomic_val_t before;
+
+	do {
+		size_t active = ram_retained_ab_active(atomic_get(SLOT_SEQ(SLOT(var, a_slot_size, 0))),
+						       atomic_get(SLOT_SEQ(SLOT(var, a_slot_size, 1))));
+		const uint8_t *slot = SLOT(var, a_slot_size, active);
+
+		seq = SLOT_SEQ(slot);
+		before = atomic_get(seq);
+		if ((before & 1) != 0) {
+			continue;
 		}
 
-		/* Move to the first address in the next section. */
-		addr += section_size - (addr % section_size);
-	} while (addr < addr_end);
+		memcpy(a_p_value, slot + a_var_offset, a_var_size);
+		compiler_barrier();
+	} while (atomic_get(seq) != before || (before & 1) != 0);
+}
+
+/* Copy a slot and check the copy, false if the slot isn't complete, is torn or is rewritten during the copy. */
+static bool ram_retained_ab_slot_copy(const uint8_t * a_p_slot, size_t a_var_offset, void * a_p_value, size_t a_var_size,
+				      size_t a_slot_size, atomic_val_t * a_p_seq)
+{
+	const struct ramRetSlotHeader *hdr = (const struct ramRetSlotHeader *)a_p_slot;
+	atomic_val_t before = atomic_get(SLOT_SEQ(a_p_slot));
+	uint32_t crc = sys_le32_to_cpu(hdr->crc);
+
+	if ((before & 1) != 0) {
+		return false;
+	}
+
+	memcpy(a_p_value, a_p_slot + a_var_offset, a_var_size);
+
+	if (atomic_get(SLOT_SEQ(a_p_slot)) != before) {
+		return false;
+	}
+
+	/* CRC of the copy, bytes of the slot around rr_var aren't written by ram_retained_ab_write(). */
+	uint32_t copy_crc = ram_retention_crc32((const uint8_t *)&before, sizeof(before));
+
+	copy_crc = ram_retention_crc32_update(copy_crc, a_p_slot + sizeof(struct ramRetSlotHeader),
+					      a_var_offset - sizeof(struct ramRetSlotHeader));
+	copy_crc = ram_retention_crc32_update(copy_crc, (const uint8_t *)a_p_value, a_var_size);
+	copy_crc = ram_retention_crc32_update(copy_crc, a_p_slot + a_var_offset + a_var_size,
+					      a_slot_size - a_var_offset - a_var_size);
+
+	*a_p_seq = before;
+
+	return (copy_crc == crc);
+}
+
+/*
+ * @brief read the newest valid slot of a retained variable declared with RamRetTypeDeclareAB(), checking the CRC of the copy.
+ *        For readers of a variable that isn't validated by their own boot pass, i.e. a variable written by another core.
+ *        Lock-free and read only, a slot torn by a reset of its writer or rewritten during the copy falls back to the other slot.
+ * @param [in]  a_p_retained_var 	pointer to the ram retained variable
+ * @param [in]  a_var_offset 		offset of rr_var in a slot
+ * @param [out] a_p_value 		pointer to the copy
+ * @param [in]  a_var_size 		size of rr_var
+ * @param [in]  a_slot_size 		size of a slot
+ * @param [out] a_p_seq 		sequence number of the copied slot, can be NULL.
+ * @return 0 on success, -ENODATA if no slot is valid.
+ */
+int ram_retained_ab_read_checked(const void * a_p_retained_var, size_t a_var_offset, void * a_p_value, size_t a_var_size,
+				 size_t a_slot_size, uint32_t * a_p_seq)
+{
+	const uint8_t *var = (const uint8_t *)a_p_retained_var;
+	size_t active = ram_retained_ab_active(atomic_get(SLOT_SEQ(SLOT(var, a_slot_size, 0))),
+					       atomic_get(SLOT_SEQ(SLOT(var, a_slot_size, 1))));
+	atomic_val_t seq;
+
+	/* Newest slot first, the older one is only rewritten after the newest one is complete. */
+	if (!ram_retained_ab_slot_copy(SLOT(var, a_slot_size, active), a_var_offset, a_p_value, a_var_size, a_slot_size, &seq) &&
+	    !ram_retained_ab_slot_copy(SLOT(var, a_slot_size, 1 - active), a_var_offset, a_p_value, a_var_size, a_slot_size, &seq)) {
+		return -ENODATA;
+	}
+
+	if (a_p_seq != NULL) {
+		*a_p_seq = (uint32_t)seq;
+	}
 
 	return 0;
 }
 
+/*
+ * @brief check the slots of the retained variable declared with RamRetTypeDeclareAB() without modifying it.
+ * @param [in] a_retained_var_ptr 	pointer to the ram retained variable
+ * @param [in] a_retained_crc_offset 	offsetof the crc end marker, size of both slots.
+ * @return true if at least one slot is valid, false if not.
+ */
+bool ram_retained_check_ab(const void * a_retained_var_ptr, size_t a_retained_crc_offset)
+{
+	size_t slot_size = a_retained_crc_offset / 2;
+
+	return (ram_retained_ab_slot_check(SLOT(a_retained_var_ptr, slot_size, 0), slot_size) ||
+		ram_retained_ab_slot_check(SLOT(a_retained_var_ptr, slot_size, 1), slot_size));
+}
+
+/*
+ * @brief boot time recovery of the retained variable declared with RamRetTypeDeclareAB().
+ *        Slots are checked once each, a slot that is invalid (i.e. its write was interrupted by a reset)
+ *        is overwritten with the valid one, so both slots are valid afterwards.
+ * @param [in] a_retained_var_ptr 	pointer to the ram retained variable
+ * @param [in] a_retained_crc_offset 	offsetof the crc end marker, size of both slots.
+ * @return true if at least one slot was valid, false if not. Variable isn't modified if false.
+ */
+bool ram_retained_recover_ab(void * a_retained_var_ptr, size_t a_retained_crc_offset)
+{
+	size_t slot_size = a_retained_crc_offset / 2;
+	uint8_t *slot0 = SLOT(a_retained_var_ptr, slot_size, 0);
+	uint8_t *slot1 = SLOT(a_retained_var_ptr, slot_size, 1);
+	bool valid0 = ram_retained_ab_slot_check(slot0, slot_size);
+	bool valid1 = ram_retained_ab_slot_check(slot1, slot_size);
+
+	if (valid0 && !valid1) {
+		memcpy(slot1, slot0, slot_size);
+	} else if (valid1 && !valid0) {
+		memcpy(slot0, slot1, slot_size);
+	}
+
+	return (valid0 || valid1);
+}
 
+/* Head of a ram retention variable declared with RamRetTypeDeclareRing(), after the entries */
+#define RING_HEAD(var, stride, capacity) ((atomic_t *)SLOT(var, stride, capacity))
 
+/* Capacity of a ring from the size of the ram retention variable and the size of an entry */
+#define RING_CAPACITY(var_size, stride) (((var_size) - sizeof(atomic_t)) / (stride))
 
+/* An entry is valid if it holds the given sequence number and its CRC matches */
+static bool ram_retained_ring_entry_check(const uint8_t * a_p_entry, atomic_val_t a_seq, size_t a_stride)
+{
+	const struct ramRetSlotHeader *hdr = (const struct ramRetSlotHeader *)a_p_entry;
 
+	return ((atomic_get(SLOT_SEQ(a_p_entry)) == a_seq) &&
+		(ram_retained_slot_crc(a_p_entry, a_seq, a_stride) == sys_le32_to_cpu(hdr->crc)));
+}
+
+/*
+ * @brief append an entry to a retained ring buffer declared with RamRetTypeDeclareRing(), oldest entry is overwritten.
+ *        Entry is reserved with a single atomic increment of the head, so appends from ISRs never wait.
+ *        Only the appended entry is CRCed, cost doesn't depend on the capacity.
+ * @note  Sequence number is written before the entry and the CRC after it, so an entry torn by a reset or
+ *        by a wrapped around append is invalid and dropped, the other entries stay.
+ * @param [in] a_p_retained_var 	pointer to the ram retained variable
+ * @param [in] a_entry_offset 		offset of rr_entry in an entry slot
+ * @param [in] a_p_entry 		pointer to the new entry
+ * @param [in] a_entry_size 		size of rr_entry
+ * @param [in] a_stride 		size of an entry slot
+ * @param [in] a_capacity 		number of entries, power of two
+ * @return sequence number of the appended entry.
+ */
+uint32_t ram_retained_ring_append(void * a_p_retained_var, size_t a_entry_offset, const void * a_p_entry, size_t a_entry_size, size_t a_stride, size_t a_capacity)
+{
+	atomic_val_t seq = atomic_inc(RING_HEAD(a_p_retained_var, a_stride, a_capacity));
+	uint8_t *slot = SLOT(a_p_retained_var, a_stride, (uint32_t)seq & (a_capacity - 1));
+
+	(void)atomic_set(SLOT_SEQ(slot), seq);
+	memcpy(slot + a_entry_offset, a_p_entry, a_entry_size);
+
+	((struct ramRetSlotHeader *)slot)->crc = sys_cpu_to_le32(ram_retained_slot_crc(slot, seq, a_stride));
+
+	return (uint32_t)seq;
+}
+
+/*
+ * @brief call a_cb for every valid entry of a retained ring buffer declared with RamRetTypeDeclareRing(), oldest first.
+ * @note  Entries are passed in place, entries overwritten by appends during the walk may be skipped.
+ * @param [in] a_p_retained_var 	pointer to the ram retained variable
+ * @param [in] a_entry_offset 		offset of rr_entry in an entry slot
+ * @param [in] a_stride 		size of an entry slot
+ * @param [in] a_capacity 		number of entries, power of two
+ * @param [in] a_cb 			called with the sequence number and the entry
+ * @param [in] a_user_data 		passed to a_cb
+ * @return number of valid entries.
+ */
+size_t ram_retained_ring_foreach(const void * a_p_retained_var, size_t a_entry_offset, size_t a_stride, size_t a_capacity, ram_retained_ring_cb_t a_cb, void * a_user_data)
+{
+	uint32_t head = (uint32_t)atomic_get(RING_HEAD(a_p_retained_var, a_stride, a_capacity));
+	uint32_t count = MIN(head, (uint32_t)a_capacity);
+	size_t valid = 0;
+
+	for (uint32_t seq = head - count; seq != head; seq++) {
+		const uint8_t *slot = SLOT(a_p_retained_var, a_stride, seq & (a_capacity - 1));
+
+		if (ram_retained_ring_entry_check(slot, seq, a_stride)) {
+			a_cb(seq, slot + a_entry_offset, a_user_data);
+			valid++;
+		}
+	}
+
+	return valid;
+}
+
+/*
+ * @brief boot time repair of a retained ring buffer declared with RamRetTypeDeclareRing().
+ *        Every entry is checked once, the head is set after the newest valid entry. Torn entries are dropped,
+ *        they stay invalid, and the ring is never wiped.
+ * @param [in] a_retained_var_ptr 	pointer to the ram retained variable
+ * @param [in] a_retained_var_size 	size of the ram retained variable
+ * @param [in] a_stride 		size of an entry slot
+ * @return true if the head matched the entries, false if it is repaired.
+ */
+bool ram_retained_recover_ring(void * a_retained_var_ptr, size_t a_retained_var_size, size_t a_stride)
+{
+	size_t capacity = RING_CAPACITY(a_retained_var_size, a_stride);
+	atomic_t *head = RING_HEAD(a_retained_var_ptr, a_stride, capacity);
+	bool found = false;
+	uint32_t newest = 0;
+
+	for (size_t i = 0; i < capacity; i++) {
+		const uint8_t *slot = SLOT(a_retained_var_ptr, a_stride, i);
+		uint32_t seq = (uint32_t)atomic_get(SLOT_SEQ(slot));
+
+		if (((seq & (capacity - 1)) != i) || !ram_retained_ring_entry_check(slot, seq, a_stride)) {
+			continue;
+		}
+		if (!found || SEQ_NEWER(seq, newest)) {
+			newest = seq;
+			found = true;
+		}
+	}
+
+	uint32_t repaired = found ? (newest + 1) : 0;
+	bool valid = ((uint32_t)atomic_get(head) == repaired);
+
+	(void)atomic_set(head, repaired);
+
+	return valid;
+}
+
+/* Boot time check of a retained variable, same as ram_retained_check_integrity() but the variable may be repaired. 
+ * Returns false only if the variable has to be reset.
+ */
+static inline bool ram_retained_recover_integrity(enum ramRetIntegrity a_integrity, void * a_retained_var_ptr, size_t a_retained_var_size, size_t a_retained_crc_offset)
+{
+	if (a_integrity == RR_INTEGRITY_AB) {
+		return ram_retained_recover_ab(a_retained_var_ptr, a_retained_crc_offset);
+	}
+	if (a_integrity == RR_INTEGRITY_RING) {
+		if (!ram_retained_recover_ring(a_retained_var_ptr, a_retained_var_size, a_retained_crc_offset)) {
+			LOG_WRN("Ram ret ring head repaired");
+		}
+		return true;
+	}
+	if (a_integrity == RR_INTEGRITY_ECC) {
+		int err = ram_retained_recover_ecc(a_retained_var_ptr, a_retained_crc_offset);
+
+		if (err > 0) {
+			(void)atomic_inc(&ecc_repairs);
+			LOG_WRN("Ram ret error repaired at %p", a_retained_var_ptr);
+		}
+		return (err >= 0);
+	}
+
+	return ram_retained_check_integrity(a_integrity, a_retained_var_ptr, a_retained_crc_offset);
+}
+
+/*
+ * @brief Same as ram_retained_validate() for a ram retention type with any integrity check algorithm.
+ * @param [in] a_integrity 		integrity check algorithm of the ram retention type.
+ * @param [in] a_retained_var_ptr 	pointer to the ram retained variable
+ * @param [in] a_retained_var_size 	size of the ram retained variable
+ * @param [in] a_retained_crc_offset 	ram retention type variable's crc offset.
+ * @return true if valid, false if not.
+ */
+bool ram_retained_validate_integrity(enum ramRetIntegrity a_integrity, void * a_retained_var_ptr, size_t a_retained_var_size, size_t a_retained_crc_offset)
+{
+	bool valid = !ram_retention_skip_validation() &&
+		     ram_retained_recover_integrity(a_integrity, a_retained_var_ptr, a_retained_var_size, a_retained_crc_offset);
+
+	/* If the check isn't valid, reset the retained data.  Reset data is
+	 * committed, so incremental updates (i.e. RR_Bitset_Set()) start from
+	 * a valid CRC.
+	 */
+	if (!valid) {
+		memset(a_retained_var_ptr, 0, a_retained_var_size);
+		ram_retained_update_integrity(a_integrity, a_retained_var_ptr, a_retained_crc_offset);
+	}
+
+	(void)ram_range_retain(a_retained_var_ptr, a_retained_var_size, true);
+
+	return valid;
+}
+
+/* Add the RAM OFF retention bits of every section covered by the provided
+ * object to the per block masks.
+ *
+ * Only the first and the last section of the range are computed, the
+ * sections in between are walked without any division.
+ *
+ * @param masks retention masks, one for each RAM block
+ *
+ * @param ptr pointer to the start of the retainable object
+ *
+ * @param len length of the retainable object
+ *
+ * @return 0 on success, -EINVAL if the range is empty or not within SRAM
+ */
+int ram_retain_masks_add(uint32_t masks[RR_RAM_BLOCK_COUNT],
+			 const void *ptr,
+			 size_t len)
+{
+	uintptr_t addr = (uintptr_t)ptr;
+	uintptr_t addr_last;
+
+	/* Error if the provided range is empty or doesn't lie
+	 * entirely within the SRAM address space.
+	 */
+	if ((len == 0U)
+	    || (addr < SRAM_BEGIN)
+	    || (addr > (SRAM_END - len))) {
+		return -EINVAL;
+	}
+
+	addr_last = addr + len - 1U;
+
+	/* Sections of the small blocks, two of them in each block. */
+	if (addr < LARGE_SECTION_BEGIN) {
+		uint32_t first = (addr - SRAM_BEGIN) / SMALL_SECTION_SIZE;
+		uint32_t last = (MIN(addr_last, LARGE_SECTION_BEGIN - 1U) - SRAM_BEGIN) / SMALL_SECTION_SIZE;
+
+		for (uint32_t section = first; section <= last; section++) {
+			masks[section / SMALL_SECTIONS_PER_BLOCK] |=
+				BIT((section % SMALL_SECTIONS_PER_BLOCK) + RETENTION_POS);
+		}
+	}
+
+	/* Sections of the large block.  RAM[x] supports only 16 sections,
+	 * each its own bit for POWER (0..15) and RETENTION (16..31).  We
+	 * don't know directly how many sections are present, so assume
+	 * they all are; the true limit will be determined by the SRAM size.
+	 */
+#if (LARGE_SECTIONS_PER_BLOCK != 0)
+	if (addr_last >= LARGE_SECTION_BEGIN) {
+		uint32_t first = (MAX(addr, LARGE_SECTION_BEGIN) - LARGE_SECTION_BEGIN) / LARGE_SECTION_SIZE;
+		uint32_t last = (addr_last - LARGE_SECTION_BEGIN) / LARGE_SECTION_SIZE;
+
+		if (last >= LARGE_SECTIONS_PER_BLOCK) {
+			return -EINVAL;
+		}
+
+		for (uint32_t section = first; section <= last; section++) {
+			masks[SMALL_BLOCK_COUNT] |= BIT(section + RETENTION_POS);
+		}
+	}
+#else
+	/* Backend has no large block, SRAM is covered by small sections only. */
+	if (addr_last >= LARGE_SECTION_BEGIN) {
+		return -EINVAL;
+	}
+#endif
+
+	return 0;
+}
+
+/* Set or clear RAM retention in SYSTEM_OFF for the provided per block masks.
+ *
+ * Each RAM[n].POWERSET/POWERCLR register is written at most once, blocks
+ * with an empty mask aren't written at all.
+ *
+ * @param masks retention masks, one for each RAM block
+ *
+ * @param enable true to enable retention, false to clear retention
+ */
+void ram_retain_masks_apply(const uint32_t masks[RR_RAM_BLOCK_COUNT], bool enable)
+{
+	for (uint8_t block = 0; block < RR_RAM_BLOCK_COUNT; block++) {
+		if (masks[block] == 0U) {
+			continue;
+		}
+
+		if (enable) {
+			rr_hal_ram_retention_set(block, masks[block]);
+		} else {
+			rr_hal_ram_retention_clear(block, masks[block]);
+		}
+	}
+}
+
+/* Set or clear RAM retention in SYSTEM_OFF for a list of objects.
+ *
+ * Retention bits of all ranges are merged first, so a section shared by
+ * several objects costs a single register write.
+ *
+ * @param ranges list of the retainable objects
+ *
+ * @param count number of elements in ranges
+ *
+ * @param enable true to enable retention, false to clear retention
+ *
+ * @return 0 on success, -EINVAL if any of the ranges is invalid.  Nothing
+ * is written in that case.
+ */
+int ram_ranges_retain(const struct ramRetRange *ranges,
+		      size_t count,
+		      bool enable)
+{
+	uint32_t masks[RR_RAM_BLOCK_COUNT] = {0};
+
+	for (size_t i = 0; i < count; i++) {
+		int err = ram_retain_masks_add(masks, ranges[i].ptr, ranges[i].len);
+
+		if (err != 0) {
+			return err;
+		}
+	}
+
+	ram_retain_masks_apply(masks, enable);
+
+	return 0;
+}
+
+/* Set or clear RAM retention in SYSTEM_OFF for the provided object.
+ *
+ * @note Registers are written by the backend selected with the
+ * CONFIG_APP_RETENTION_BACKEND choice, see ram_retention_hal.h.
+ *
+ * @param ptr pointer to the start of the retainable object
+ *
+ * @param len length of the retainable object
+ *
+ * @param enable true to enable retention, false to clear retention
+ */
+int ram_range_retain(const void *ptr,
+			    size_t len,
+			    bool enable)
+{
+	const struct ramRetRange range = {
+		.ptr = ptr,
+		.len = len,
+	};
+
+	return ram_ranges_retain(&range, 1, enable);
+}
+
+
+
+#if defined(CONFIG_APP_RETENTION_STATS)
+
+static struct ramRetBootStats boot_stats;
+
+/* DWT cycle counter is enabled by the boot pass, it isn't reset so other users aren't disturbed. */
+static void ram_retention_stats_init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t ram_retention_stats_now(void)
+{
+	return DWT->CYCCNT;
+}
+
+static void ram_retention_stats_commit(const struct ramRetDescriptor *desc, uint32_t start)
+{
+	uint32_t cycles = ram_retention_stats_now() - start;
+	struct ramRetStats *stats = desc->stats;
+
+	if (stats == NULL) {
+		return;
+	}
+
+	unsigned int key = irq_lock();
+
+	if ((stats->commit_count == 0U) || (cycles < stats->commit_min)) {
+		stats->commit_min = cycles;
+	}
+	stats->commit_max = MAX(stats->commit_max, cycles);
+	stats->commit_total += cycles;
+	stats->commit_count++;
+
+	irq_unlock(key);
+}
+
+static void ram_retention_stats_validate(const struct ramRetDescriptor *desc, uint32_t start, bool valid, bool repaired)
+{
+	uint32_t cycles = ram_retention_stats_now() - start;
+
+	if (desc->stats != NULL) {
+		desc->stats->validate_cycles = cycles;
+		desc->stats->crc_failures += valid ? 0U : 1U;
+		desc->stats->ecc_repairs += repaired ? 1U : 0U;
+	}
+}
+
+const struct ramRetStats *ram_retained_stats(const struct ramRetDescriptor *a_desc)
+{
+	return a_desc->stats;
+}
+
+const struct ramRetBootStats *ram_retained_boot_stats(void)
+{
+	return &boot_stats;
+}
+
+#else
+
+static inline void ram_retention_stats_init(void) {}
+static inline uint32_t ram_retention_stats_now(void) { return 0; }
+static inline void ram_retention_stats_commit(const struct ramRetDescriptor *desc, uint32_t start) {}
+static inline void ram_retention_stats_validate(const struct ramRetDescriptor *desc, uint32_t start, bool valid, bool repaired) {}
+
+const struct ramRetStats *ram_retained_stats(const struct ramRetDescriptor *a_desc)
+{
+	ARG_UNUSED(a_desc);
+	return NULL;
+}
+
+const struct ramRetBootStats *ram_retained_boot_stats(void)
+{
+	return NULL;
+}
+
+#endif /* CONFIG_APP_RETENTION_STATS */
+
+/* true for a lazy variable that isn't accessed yet, it can't be changed so it isn't committed. */
+static inline bool ram_retained_desc_pending(const struct ramRetDescriptor *desc)
+{
+	return desc->lazy && !atomic_test_bit(desc->state, RR_STATE_VALIDATED);
+}
+
+/* Committed variable is written to flash by the next spill. */
+static inline void ram_retained_desc_unsaved(const struct ramRetDescriptor *desc)
+{
+#if defined(CONFIG_APP_RETENTION_SPILL)
+	atomic_set_bit(desc->state, RR_STATE_UNSAVED);
+#else
+	ARG_UNUSED(desc);
+#endif
+}
+
+/* Commit one variable given by its descriptor, its dirty mark is cleared. */
+static inline void ram_retained_update_desc(const struct ramRetDescriptor *desc)
+{
+	if (desc->state != NULL) {
+		atomic_clear_bit(desc->state, RR_STATE_DIRTY);
+
+		if (ram_retained_desc_pending(desc)) {
+			return;
+		}
+
+		ram_retained_desc_unsaved(desc);
+	}
+
+	uint32_t start = ram_retention_stats_now();
+
+	ram_retained_update_integrity(desc->integrity, desc->addr, desc->crc_offset);
+	ram_retention_stats_commit(desc, start);
+}
+
+void ram_retained_update_many(const struct ramRetDescriptor *const a_descs[], size_t a_count)
+{
+	unsigned int key = irq_lock();
+
+	for (size_t i = 0; i < a_count; i++) {
+		ram_retained_update_desc(a_descs[i]);
+	}
+
+	irq_unlock(key);
+}
+
+void ram_retained_update_descs(const struct ramRetDescriptor a_descs[], size_t a_count)
+{
+	unsigned int key = irq_lock();
+
+	for (size_t i = 0; i < a_count; i++) {
+		ram_retained_update_desc(&a_descs[i]);
+	}
+
+	irq_unlock(key);
+}
+
+void ram_retained_flush(void)
+{
+	STRUCT_SECTION_FOREACH(ramRetDescriptor, desc) {
+		/* Cleared before the update, so a change racing with the
+		 * update marks the variable dirty again.
+		 */
+		if (atomic_test_and_clear_bit(desc->state, RR_STATE_DIRTY) && !ram_retained_desc_pending(desc)) {
+			uint32_t start = ram_retention_stats_now();
+
+			ram_retained_desc_unsaved(desc);
+
+			ram_retained_update_integrity(desc->integrity, desc->addr, desc->crc_offset);
+			ram_retention_stats_commit(desc, start);
+		}
+	}
+}
+
+/* true if the variable has no layout header or the header holds the layout of the current firmware. */
+static inline bool ram_retained_layout_matches(const struct ramRetDescriptor *desc)
+{
+	return (desc->layout == 0U) || (sys_get_le32(desc->addr) == desc->layout);
+}
+
+/* Convert a variable retained with another layout by its migration function, then commit it with the current layout.
+ * Only data of a registered previous layout that passes the CRC-32 of that layout is given to the migration function.
+ */
+static bool ram_retained_migrate_desc(const struct ramRetDescriptor *desc)
+{
+	uint32_t old_layout = sys_get_le32(desc->addr);
+
+	STRUCT_SECTION_FOREACH(ramRetMigration, migration) {
+		if ((migration->desc != desc) || (migration->old_layout != old_layout)) {
+			continue;
+		}
+
+		if (!ram_retained_check_integrity(RR_INTEGRITY_CRC32, desc->addr, migration->old_crc_offset)) {
+			LOG_WRN("Ram ret variable <%s> of layout 0x%08" PRIx32 " isn't valid, it isn't migrated", desc->name, old_layout);
+			return false;
+		}
+
+		if (!migration->migrate(desc->addr, old_layout)) {
+			return false;
+		}
+
+		sys_put_le32(desc->layout, desc->addr);
+		ram_retained_update_integrity(desc->integrity, desc->addr, desc->crc_offset);
+		LOG_INF("Ram ret variable <%s> is migrated from layout 0x%08" PRIx32, desc->name, old_layout);
+
+		return true;
+	}
+
+	return false;
+}
+
+/* Reset one variable given by its descriptor to its flash copy if it has a valid one, else to its default value and commit it.
+ * Flash is only read by the init pass, the first access of a lazy variable runs with IRQs locked, maybe in an ISR.
+ */
+static void ram_retained_reset_desc(const struct ramRetDescriptor *desc)
+{
+#if defined(CONFIG_APP_RETENTION_SPILL)
+	if (!init_pass_done && !k_is_in_isr() && ram_retention_spill_restore(desc) &&
+	    (ram_retained_layout_matches(desc) || ram_retained_migrate_desc(desc))) {
+		LOG_INF("Ram ret variable <%s> is restored from flash", desc->name);
+		return;
+	}
+#endif
+
+	if (desc->defaults != NULL) {
+		memcpy(desc->addr, desc->defaults, desc->size);
+	} else {
+		memset(desc->addr, 0, desc->size);
+	}
+
+	if (desc->layout != 0U) {
+		sys_put_le32(desc->layout, desc->addr);
+	}
+
+	ram_retained_update_integrity(desc->integrity, desc->addr, desc->crc_offset);
+}
+
+/* Check one variable given by its descriptor, reset it if it isn't valid.
+ * Layout header is compared before any CRC work, data of another layout is only migrated or reset.
+ */
+static void ram_retained_validate_desc(const struct ramRetDescriptor *desc)
+{
+	uint32_t start = ram_retention_stats_now();
+	atomic_val_t repairs = atomic_get(&ecc_repairs);
+	bool valid = ram_retained_layout_matches(desc) ?
+		     ram_retained_recover_integrity(desc->integrity, desc->addr, desc->size, desc->crc_offset) :
+		     ram_retained_migrate_desc(desc);
+
+	if (!valid) {
+		ram_retained_reset_desc(desc);
+	}
+	ram_retention_stats_validate(desc, start, valid, atomic_get(&ecc_repairs) != repairs);
+
+	if (!valid) {
+		LOG_ERR("Ram ret initialization error of variable <%s>", desc->name);
+	}
+
+	atomic_set_bit(desc->state, RR_STATE_VALIDATED);
+}
+
+/*
+ * @brief Pointer to a registered variable, a lazy variable is validated at its first access.
+ * @param [in] a_desc descriptor of the variable
+ * @return address of the variable
+ */
+void *ram_retained_access(const struct ramRetDescriptor *a_desc)
+{
+	if (!atomic_test_bit(a_desc->state, RR_STATE_VALIDATED)) {
+		unsigned int key = irq_lock();
+
+		/* Checked again, another context may have validated it. */
+		if (!atomic_test_bit(a_desc->state, RR_STATE_VALIDATED)) {
+			ram_retained_validate_desc(a_desc);
+		}
+
+		irq_unlock(key);
+	}
+
+	return a_desc->addr;
+}
+
+/*
+ * @brief FNV-1a hash of the name of a registered variable, stays the same when other variables are added or removed.
+ */
+uint32_t ram_retained_desc_id(const struct ramRetDescriptor *a_desc)
+{
+	uint32_t hash = 2166136261U;
+
+	for (const char *c = a_desc->name; *c != '\0'; c++) {
+		hash ^= (uint8_t)*c;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+/*
+ * @brief Boot time validation pass of every variable registered with RR_Init_Var_Ram_Retention().
+ *        Variables with invalid CRC are reset to their default value, then the whole ".ram_retained" section is retained at once
+ *        with a single register write per RAM block. With CONFIG_APP_RETENTION_EXCLUSIVE retention of every other section is cleared.
+ *        After a power-on or brown-out reset, variables are reset without validation (CONFIG_APP_RETENTION_SKIP_ON_COLD_BOOT).
+ *        Lazy variables are validated at their first access instead, see RR_Init_Var_Ram_Retention_Lazy().
+ */
+static int ram_retention_init_registered(const struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	ram_retention_stats_init();
+
+	if (rr_hal_init() != 0) {
+		LOG_ERR("Ram ret backend isn't ready, retention isn't set");
+	}
+
+#if defined(CONFIG_APP_RETENTION_SPILL)
+	/* Flash copies are restored by the pass, the file system is mounted first. */
+	if (ram_retention_spill_mount() != 0) {
+		LOG_ERR("Ram ret spill partition isn't mounted, variables aren't restored from flash");
+	}
+#endif
+
+	uint32_t pass_start = ram_retention_stats_now();
+
+	/* Retained RAM is garbage after a power-on or brown-out reset, nothing to validate. */
+	bool cold_boot = ram_retention_skip_validation();
+
+	STRUCT_SECTION_FOREACH(ramRetDescriptor, desc) {
+		if (cold_boot) {
+			uint32_t start = ram_retention_stats_now();
+
+			ram_retained_reset_desc(desc);
+			ram_retention_stats_validate(desc, start, true, false);
+			atomic_set_bit(desc->state, RR_STATE_VALIDATED);
+		} else if (!desc->lazy) {
+			ram_retained_validate_desc(desc);
+		}
+	}
+
+#if !defined(CONFIG_APP_RETENTION_BACKEND_POWER)
+	/* Masks are computed at link time for the nRF52 layout only, emulated SRAM isn't known at link time. */
+	uint32_t section_masks[RR_RAM_BLOCK_COUNT] = {0};
+
+	(void)ram_retain_masks_add(section_masks, __ram_retained_start, __ram_retained_end - __ram_retained_start);
+#else
+	/* Masks of the whole section are precomputed by the linker. */
+	const uint32_t section_masks[RR_RAM_BLOCK_COUNT] = {
+		(uint32_t)(uintptr_t)__ram_retained_mask_0,
+		(uint32_t)(uintptr_t)__ram_retained_mask_1,
+		(uint32_t)(uintptr_t)__ram_retained_mask_2,
+		(uint32_t)(uintptr_t)__ram_retained_mask_3,
+		(uint32_t)(uintptr_t)__ram_retained_mask_4,
+		(uint32_t)(uintptr_t)__ram_retained_mask_5,
+		(uint32_t)(uintptr_t)__ram_retained_mask_6,
+		(uint32_t)(uintptr_t)__ram_retained_mask_7,
+		(uint32_t)(uintptr_t)__ram_retained_mask_8,
+	};
+#endif
+
+	uint32_t retain_start = ram_retention_stats_now();
+
+#if defined(CONFIG_APP_RETENTION_EXCLUSIVE)
+	/* Every other section of SRAM isn't retained. */
+	uint32_t other_masks[RR_RAM_BLOCK_COUNT] = {0};
+
+	(void)ram_retain_masks_add(other_masks, (const void *)SRAM_BEGIN, SRAM_END - SRAM_BEGIN);
+	for (size_t block = 0; block < RR_RAM_BLOCK_COUNT; block++) {
+		other_masks[block] &= ~section_masks[block];
+	}
+
+	ram_retain_masks_apply(other_masks, false);
+#endif
+
+	ram_retain_masks_apply(section_masks, true);
+
+#if defined(CONFIG_APP_RETENTION_STATS)
+	boot_stats.retain_cycles = ram_retention_stats_now() - retain_start;
+	boot_stats.pass_cycles = ram_retention_stats_now() - pass_start;
+#else
+	ARG_UNUSED(pass_start);
+	ARG_UNUSED(retain_start);
+#endif
+
+	init_pass_done = true;
+
+	return 0;
+}
+
+SYS_INIT(ram_retention_init_registered, APPLICATION, 30);
+
+#if defined(CONFIG_APP_RETENTION_BACKEND_POWER_EMUL)
+void ram_retention_emul_reinit(void)
+{
+	atomic_clear(&reset_reason_read);
+	init_pass_done = false;
+
+	STRUCT_SECTION_FOREACH(ramRetDescriptor, desc) {
+		atomic_clear(desc->state);
+	}
+
+	(void)ram_retention_init_registered(NULL);
+}
+#endif
@@ -5,7 +5,7 @@
  * 
  * @note following Kconfig options must be enabled for utilizing ram retention:
 	CONFIG_APP_RETENTION=y
-	CONFIG_CRC=y
+	CONFIG_CRC=y		(selected by CONFIG_APP_RETENTION)
  * @note following Kconfig options must be configured for utilizing logging:
 	CONFIG_LOG=y
 	CONFIG_LOG_BACKEND_SHOW_COLOR=y  (optional)
@@ -30,7 +30,10 @@ extern "C" {
 #include <stdbool.h>
 #include <inttypes.h>
 
+#include <zephyr/toolchain.h>
 #include <zephyr/sys/util.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/iterable_sections.h>
 #include <zephyr/logging/log.h>
 
 #include "sys_init_utils.h"
@@ -39,11 +42,94 @@ extern "C" {
 
 
 
+/**
+ * @brief Integrity check algorithms that can be selected for a ram retention type with RamRetTypeDeclareIntegrity().
+*/
+enum ramRetIntegrity{
+	RR_INTEGRITY_CRC32 = 0,		// CRC-32/ISO-HDLC in a uint32_t crc variable, default algorithm of RamRetTypeDeclare().
+	RR_INTEGRITY_CRC16,		// CRC-16/CCITT (Zephyr's crc16_ccitt, seed 0xFFFF) in a uint16_t crc variable.
+	RR_INTEGRITY_FLETCHER32,	// Fletcher-32 in a uint32_t crc variable, cheapest check that still detects most errors.
+	RR_INTEGRITY_NONE,		// no check at all, crc variable takes no space. Variable always counts as valid, even at first power up.
+	RR_INTEGRITY_INVERTED,		// bitwise inverted copy of a 32-bit rr_var in an atomic_t crc variable, used by the rr_atomic_*() helpers.
+	RR_INTEGRITY_AB,		// two CRC-32 checked slots with sequence numbers, newest valid one is used. Only for RamRetTypeDeclareAB().
+	RR_INTEGRITY_RING,		// CRC-32 checked entries with sequence numbers, checked one by one. Only for RamRetTypeDeclareRing().
+	RR_INTEGRITY_ECC,		// CRC-32 and a 32-bit column parity word, an error within one aligned 32-bit word is repaired at validation.
+};
+
+/**
+ * @brief INTERNAL. crc variable declaration of each integrity check algorithm.
+*/
+#define _RR_INTEGRITY_FIELD_CRC32		uint32_t 	crc
+#define _RR_INTEGRITY_FIELD_CRC16		uint16_t 	crc
+#define _RR_INTEGRITY_FIELD_FLETCHER32	uint32_t 	crc
+#define _RR_INTEGRITY_FIELD_NONE		uint8_t 	crc[0]
+#define _RR_INTEGRITY_FIELD_INVERTED		atomic_t 	crc
+#define _RR_INTEGRITY_FIELD_AB		uint8_t 	crc[0]		// end marker, crc of each slot is in its header
+#define _RR_INTEGRITY_FIELD_RING		uint8_t 	crc[0]		// end marker, crc of each entry is in its header
+#define _RR_INTEGRITY_FIELD_ECC		uint32_t 	crc; uint32_t rr_parity	// parity is the XOR of every 32-bit word before crc
+
+/**
+ *  @brief Attach an integrity check algorithm to a ram retention type. RamRetTypeDeclare() and RamRetTypeDeclareIntegrity() already do this.
+ *  @note  Only needed when a ram retention type is declared explicitly as a struct (see RamRetUint32t), the algorithm must match the type of its crc variable.
+ *  @param [in] typedef_name name of the ram retention type.
+ *  @param [in] integrity    one of CRC32, CRC16, FLETCHER32, NONE, INVERTED, AB, RING, ECC.
+ *  @note  user has to put semicolon (;) themself.
+*/
+#define RamRetTypeIntegrity(typedef_name, integrity) 	\
+	enum { typedef_name##_rr_integrity = RR_INTEGRITY_##integrity, typedef_name##_rr_layout = 0 }
+
+/**
+ *  @brief INTERNAL. Integrity check algorithm of the given ram retention type, compile time constant.
+*/
+#define _RR_TYPE_INTEGRITY(typedef_name) ((enum ramRetIntegrity)typedef_name##_rr_integrity)
+
+/**
+ *  @brief INTERNAL. Hash of the size of var_type and the offset and size of the listed fields, compile time constant.
+*/
+#define _RR_LAYOUT_FIELD(idx, field, var_type)									\
+	((((uint32_t)offsetof(var_type, field) << 16) ^ (uint32_t)sizeof(((var_type *)0)->field)) * (0x9E3779B1U + 2U * (idx)))
+#define _RR_LAYOUT_FIELDS_HASH(var_type, ...)									\
+	((int)(((uint32_t)sizeof(var_type) * 0x85EBCA6BU + FOR_EACH_IDX_FIXED_ARG(_RR_LAYOUT_FIELD, (+), var_type, __VA_ARGS__)) & 0x7FFFFFFFU))
+
+/**
+ *  @brief INTERNAL. FNV-1a of the first 32 characters of a string literal, folded by the compiler in static initializers.
+*/
+#define _RR_NAME_HASH_1(h, s, i) (((h) ^ (uint32_t)(((i) < sizeof(s) - 1) ? (uint8_t)(s)[((i) < sizeof(s)) ? (i) : 0] : 0)) * 16777619U)
+#define _RR_NAME_HASH_4(h, s, i) _RR_NAME_HASH_1(_RR_NAME_HASH_1(_RR_NAME_HASH_1(_RR_NAME_HASH_1(h, s, i), s, (i) + 1), s, (i) + 2), s, (i) + 3)
+#define _RR_NAME_HASH_16(h, s, i) _RR_NAME_HASH_4(_RR_NAME_HASH_4(_RR_NAME_HASH_4(_RR_NAME_HASH_4(h, s, i), s, (i) + 4), s, (i) + 8), s, (i) + 12)
+#define _RR_NAME_HASH(s) _RR_NAME_HASH_16(_RR_NAME_HASH_16(2166136261U, s, 0), s, 16)
+
+/**
+ *  @brief INTERNAL. Layout hash of a ram retention type stored in its rr_layout header, 0 for types without the header.
+*/
+#define _RR_TYPE_LAYOUT(typedef_name)										\
+	((typedef_name##_rr_layout != 0) ? (((uint32_t)typedef_name##_rr_layout ^ _RR_NAME_HASH(#typedef_name)) | 1U) : 0U)
+
+/**
+ *  @brief Same as RamRetTypeDeclare() but the integrity check algorithm of the type is selected at compile time.
+ *  @param [in] var_type type of the variable (i.e. int, i.e. struct foo) that will be ram ratained.
+ *  @param [in] typedef_name name given to the typedef created for the ram retention variable.
+ *  @param [in] integrity one of CRC32, CRC16, FLETCHER32, NONE, INVERTED, ECC. See enum ramRetIntegrity.
+ *  @note  user has to put semicolon (;) themself.
+ *  @note  RR_Var_Ram_Ret() and the other macros taking the ram retention type call the routine of the selected algorithm directly, there is no runtime selection.
+ *  @note  ECC costs 4 more bytes than CRC32 and a XOR pass at every commit. A variable that fails its CRC at validation is repaired instead
+ *         of reset when the error lies within one aligned 32-bit word of rr_var or in the parity word (i.e. a flipped bit or byte),
+ *         see ram_retained_ecc_repairs(). An error in the crc word resets the variable, like CRC32 does.
+ *  @example  RamRetTypeDeclareIntegrity(uint32_t, RamRetIsrCounter, FLETCHER32);
+*/
+#define RamRetTypeDeclareIntegrity(var_type, typedef_name, integrity) 	\
+	typedef struct _##typedef_name{				\
+		var_type	rr_var;						\
+		_RR_INTEGRITY_FIELD_##integrity;			\
+	}typedef_name;								\
+	RamRetTypeIntegrity(typedef_name, integrity)
+
 /**
  *  @brief Declare a composite struct type that is used for defining ram retention variables on top of existing types.
  *  @param [in] var_type type of the variable (i.e. int, i.e. struct foo) that will be ram ratained.
  *  @param [in] typedef_name name given to the typedef created for the ram retention variable.
  *  @note  user has to put semicolon (;) themself.
+ *  @note  Type is checked with CRC-32, use RamRetTypeDeclareIntegrity() for selecting another algorithm.
  *  @recommended: Start @param typedef_name with "RamRet" prefix for having naming compability with the other functions in this library. i.e. RamRetFoo
  *  @example  typical use looks like: 
 			struct  my_struct{ // use of a struct is not mandatory, any type is valid.
@@ -53,32 +139,180 @@ extern "C" {
 			RR_Init_Var_Ram_Retention(RamRetMyType, g_rr_foo);  // or if you just want to defie a variable use: RamRetVarDefine(RamRetMyType, g_rr_foo);
 */
 #define RamRetTypeDeclare(var_type, typedef_name) 	\
+	RamRetTypeDeclareIntegrity(var_type, typedef_name, CRC32)
+
+
+
+/**
+ *  @brief Same as RamRetTypeDeclare() but with a layout header in front of rr_var, so that a variable retained by a firmware with another
+ *         layout of var_type isn't misread. Layout hash is computed at compile time from the size of var_type, the offset and size of the
+ *         listed fields and the name of the type. Boot pass compares it before the CRC, a variable whose layout changed is converted by
+ *         its migration function (see RR_Var_Migration_Define()) or reset if it has none.
+ *  @note  Type is aligned to CONFIG_APP_RETENTION_LAYOUT_SLOT_SIZE and padded to a whole number of slots. Variables of these types are
+ *         linked first in the ".ram_retained" section and in the order of their names, so a variable keeps its address when its layout
+ *         changes within its slots or when other variables change.
+ *  @note  Only variables defined with RR_Init_Var_Ram_Retention() are checked. A field that isn't listed only changes the hash through the size.
+ *  @note  user has to put semicolon (;) themself.
+ *  @param [in] var_type     type of the variable (i.e. struct foo) that will be ram ratained.
+ *  @param [in] typedef_name name given to the typedef created for the ram retention variable.
+ *  @param [in] ...          fields of var_type covered by the hash, i.e. boots, mode, name
+ *  @example  RamRetTypeDeclareLayout(struct settings, RamRetSettings, boots, mode, name);
+*/
+#define RamRetTypeDeclareLayout(var_type, typedef_name, ...) 	\
+	typedef struct _##typedef_name{				\
+		uint32_t	rr_layout;					\
+		var_type	rr_var;						\
+		uint32_t	crc;						\
+	} __aligned(CONFIG_APP_RETENTION_LAYOUT_SLOT_SIZE) typedef_name;	\
+	enum { typedef_name##_rr_integrity = RR_INTEGRITY_CRC32,		\
+	       typedef_name##_rr_layout = _RR_LAYOUT_FIELDS_HASH(var_type, __VA_ARGS__) }
+
+
+
+/**
+ *  @brief Declare a ram retention type with a sequence counter, for tear-free concurrent access with RR_Seq_Write() and RR_Seq_Read() (seqlock).
+ *  @note  Writers never block and never corrupt each other: a writer that finds another write in progress gets -EBUSY.
+ *         Readers never block either: a reader that finds a write in progress gets -EBUSY, so they are safe in ISRs.
+ *  @note  Type is checked with CRC-32 which also covers the sequence counter, so it can be used with RR_Init_Var_Ram_Retention().
+ *  @param [in] var_type type of the variable (i.e. int, i.e. struct foo) that will be ram ratained.
+ *  @param [in] typedef_name name given to the typedef created for the ram retention variable.
+ *  @note  user has to put semicolon (;) themself.
+ *  @example  RamRetTypeDeclareSeq(struct my_struct, RamRetMySeqType);
+*/
+#define RamRetTypeDeclareSeq(var_type, typedef_name) 	\
 	typedef struct _##typedef_name{				\
+		atomic_t	rr_seq;						\
 		var_type	rr_var;						\
 		uint32_t 	crc;							\
-	}typedef_name
+	}typedef_name;								\
+	RamRetTypeIntegrity(typedef_name, CRC32)
+
+
+
+/**
+ * @brief Header of a slot of a ram retention type declared with RamRetTypeDeclareAB().
+*/
+struct ramRetSlotHeader{
+	uint32_t	crc;			// CRC-32 of the rest of the slot, starting from rr_seq
+	atomic_t	rr_seq;			// sequence number, even when the slot is complete, odd while it is written
+};
+
+/**
+ *  @brief Declare a double buffered (A/B) ram retention type, so a reset in the middle of a commit never loses the variable.
+ *  @note  RR_AB_Write() writes the inactive slot and publishes it with a higher sequence number, the active slot isn't touched.
+ *         At boot the newest valid slot is used and the other one is repaired from it, so an interrupted commit only loses that commit.
+ *  @note  Lock-free: a writer that finds another write in progress (i.e. the caller preempted it) gets -EBUSY. Readers never fail.
+ *  @note  Can be used with RR_Init_Var_Ram_Retention(). rr_var can't be modified in place, RR_Var_Ram_Ret() does nothing for this type.
+ *  @param [in] var_type type of the variable (i.e. int, i.e. struct foo) that will be ram ratained.
+ *  @param [in] typedef_name name given to the typedef created for the ram retention variable.
+ *  @note  user has to put semicolon (;) themself.
+ *  @example  RamRetTypeDeclareAB(struct my_struct, RamRetMyABType);
+*/
+#define RamRetTypeDeclareAB(var_type, typedef_name) 	\
+	typedef struct _##typedef_name{				\
+		struct{							\
+			struct ramRetSlotHeader	rr_hdr;		\
+			var_type		rr_var;			\
+		} rr_slot[2];						\
+		_RR_INTEGRITY_FIELD_AB;				\
+	}typedef_name;								\
+	RamRetTypeIntegrity(typedef_name, AB)
+
+
+
+/**
+ * @brief INTERNAL. needed for using with FOR_EACH
+*/
+#define _RR_GROUP_MEMBER(member) member;
+
+/**
+ *  @brief Declare a ram retention group type, where many fields share one crc variable and have no padding between them.
+ *  @note  RamRetUint8t takes 8 bytes for 1 byte of payload, 100 uint8_t flags in a group take 104 bytes.
+ *  @note  Type is packed and checked with CRC-32, committing the group CRCs the packed fields once. A single field can be set
+ *         with RR_Group_Set() which patches the CRC instead of recomputing it. Fields are read with RR_Group_Get().
+ *  @param [in] typedef_name name given to the typedef created for the ram retention variable.
+ *  @param [in] ... field declarations, separated using commas, i.e. uint8_t boot_count, uint16_t flags, uint8_t name[8]. At most 64 fields.
+ *  @note  user has to put semicolon (;) themself.
+ *  @example  RamRetTypeDeclareGroup(RamRetMyGroup, uint8_t boot_count, uint16_t flags, uint64_t uptime);
+ *            RR_Init_Var_Ram_Retention(RamRetMyGroup, g_group);
+ *            RR_Group_Set(RamRetMyGroup, g_group, boot_count, RR_Group_Get(g_group, boot_count) + 1);
+*/
+#define RamRetTypeDeclareGroup(typedef_name, ...) 	\
+	typedef struct __packed _##typedef_name{		\
+		struct __packed{					\
+			FOR_EACH(_RR_GROUP_MEMBER, (), __VA_ARGS__)	\
+		} rr_var;						\
+		uint32_t 	crc;							\
+	}typedef_name;								\
+	RamRetTypeIntegrity(typedef_name, CRC32)
+
+
+
+/**
+ *  @brief Declare a ram retention bitset type for boolean flags, with a companion mask telling which flags are configured.
+ *  @note  Flags that aren't configured read as their default value with RR_Bitset_Get(), so no initialization workaround
+ *         (see RamRetBoolConditions) is needed. 100 flags take 36 bytes including the crc variable.
+ *  @note  RR_Bitset_Set() and RR_Bitset_Unset() are atomic and lock-free, the CRC-32 is patched for the changed word only.
+ *         Type is checked with CRC-32, so it can be used with RR_Init_Var_Ram_Retention().
+ *  @param [in] num_bits     number of flags
+ *  @param [in] typedef_name name given to the typedef created for the ram retention variable.
+ *  @note  user has to put semicolon (;) themself.
+ *  @example  RamRetTypeDeclareBitset(100, RamRetFeatureFlags);
+*/
+#define RamRetTypeDeclareBitset(num_bits, typedef_name) 	\
+	typedef struct _##typedef_name{				\
+		ATOMIC_DEFINE(rr_bits, num_bits);			\
+		ATOMIC_DEFINE(rr_configured, num_bits);		\
+		atomic_t 	crc;							\
+	}typedef_name;								\
+	RamRetTypeIntegrity(typedef_name, CRC32)
+
+
+
+/**
+ *  @brief Declare a ram retention ring buffer type, i.e. for keeping the last events before a reset.
+ *  @note  Every entry has its own CRC-32 and sequence number, so appending CRCs only the new entry. Cost doesn't depend on the capacity.
+ *  @note  RR_Ring_Append() is lock-free and safe from ISRs, oldest entry is overwritten. An entry torn by a reset is dropped at boot,
+ *         the rest of the ring is kept. Use RR_Ring_Define() for defining a variable of this type.
+ *  @param [in] entry_type type of an entry (i.e. struct my_event).
+ *  @param [in] capacity   number of entries, must be a power of two.
+ *  @param [in] typedef_name name given to the typedef created for the ram retention variable.
+ *  @note  user has to put semicolon (;) themself.
+ *  @example  RamRetTypeDeclareRing(struct my_event, 64, RamRetMyEventRing);
+*/
+#define RamRetTypeDeclareRing(entry_type, capacity, typedef_name) 	\
+	typedef struct _##typedef_name{				\
+		struct{							\
+			struct ramRetSlotHeader	rr_hdr;		\
+			entry_type		rr_entry;		\
+		} rr_entries[capacity];					\
+		atomic_t	rr_head;					\
+		_RR_INTEGRITY_FIELD_RING;				\
+	}typedef_name;								\
+	BUILD_ASSERT(IS_POWER_OF_TWO(capacity), "ring capacity must be a power of two");	\
+	RamRetTypeIntegrity(typedef_name, RING)
 
 
 
 /**
  * @brief INTERNAL. needed for using with FOR_EACH_FIXED_ARG
 */
-#define _RamRetVarDefine(var_name, var_type) __noinit var_type var_name // needed for using with FOR_EACH_FIXED_ARG
+#define _RamRetVarDefine(var_name, var_type) _RR_RETAINED_SECTION(var_name) var_type var_name // needed for using with FOR_EACH_FIXED_ARG
 
 /**
- *  @brief Define a __noninit variable with given variable type and variable name. 
+ *  @brief Define a variable with given variable type and variable name in the ".ram_retained" section, so it is retained with the other ram retention variables.
  *  @note  For primitive data types, you can alternatively use the other macros created for each specific type i.e. RamRetUint32t_
  *  @param [in] var_type type of the variable i.e. int
  *  @param [in] var_name given name for the variable
- *  @example  <RamRetVar(int, foo);> corresponds to <__noinit int foo>
+ *  @example  <RamRetVarDefine(int, foo);> corresponds to <__attribute__((__section__(".ram_retained.foo"))) int foo>
 */
-#define RamRetVarDefine(var_type, var_name) __noinit var_type var_name
+#define RamRetVarDefine(var_type, var_name) _RR_RETAINED_SECTION(var_name) var_type var_name
 
 /**
  *  @brief Similar to the macro RamRetVarDefine(var_type, var_name) but you can input many variable names as arguments.
  *  @param [in] var_type type of the variable i.e. int
  *  @param [in] ... name of the variables, separated using commas.
- *  @example  <RamRetDefineVars(int, var1, var2, var3);> corresponds to <__noinit int var1; __noinit int var2; __noinit int var3;>
+ *  @example  <RamRetDefineVars(int, var1, var2, var3);> defines var1, var2 and var3 like RamRetVarDefine(int, var1) etc.>
 */
 #define RamRetDefineVars(var_type, ...)  			\
 	 FOR_EACH_FIXED_ARG(_RamRetVarDefine, (;), var_type, __VA_ARGS__) 
@@ -115,6 +349,7 @@ extern "C" {
 
 /* ram retention struct type declarations for primitive or some other data types and some helper macros associated with them */
 /* To be more concise, some of the data types are declared with the help of macros and other are explicitly, to show both declarations */
+/* RamRetXxx_t macros don't get the variable name, they place their variables in an input section named after the type, i.e. ".ram_retained.RamRetInt" */
 
 
 
@@ -125,13 +360,13 @@ extern "C" {
 RamRetTypeDeclare(int, RamRetInt);
 
 /**
- * @brief 	Macro for user user convenience when defining __noinit variable of type RamRetInt
+ * @brief 	Macro for user user convenience when defining a variable of type RamRetInt in the ".ram_retained" section
  * @example 	RamRetInt_t foo;
  */
-#define RamRetInt_t __noinit RamRetInt
+#define RamRetInt_t _RR_RETAINED_SECTION(RamRetInt) RamRetInt
 
 /**
- * @brief 	Macro for user user convenience when defining multiple __noinit variable of type RamRetInt
+ * @brief 	Macro for user user convenience when defining multiple variables of type RamRetInt in the ".ram_retained" section
  * @param [in] ... variable names to be defined.
  * @example 	RamRetDefineInt(var1, var2, var3);
  */
@@ -155,13 +390,13 @@ RamRetTypeDeclare(int, RamRetInt);
 RamRetTypeDeclare(float, RamRetFloat);
 
 /**
- * @brief Macro for user user convenience when defining __noinit variable of type RamRetFloat
+ * @brief Macro for user user convenience when defining a variable of type RamRetFloat in the ".ram_retained" section
  * @example RamRetFloat_t foo;
  */
-#define RamRetFloat_t __noinit RamRetFloat
+#define RamRetFloat_t _RR_RETAINED_SECTION(RamRetFloat) RamRetFloat
 
 /**
- * @brief 	Macro for user user convenience when defining multiple __noinit variable of type RamRetFloat
+ * @brief 	Macro for user user convenience when defining multiple variables of type RamRetFloat in the ".ram_retained" section
  * @param [in] ... variable names to be defined.
  * @example 	RamRetDefineFloat(var1, var2, var3);
  */
@@ -185,13 +420,13 @@ RamRetTypeDeclare(float, RamRetFloat);
 RamRetTypeDeclare(double, RamRetDouble);
 
 /**
- * @brief Macro for user user convenience when defining __noinit variable of type RamRetDouble
+ * @brief Macro for user user convenience when defining a variable of type RamRetDouble in the ".ram_retained" section
  * @example RamRetDouble_t foo;
  */
-#define RamRetDouble_t __noinit RamRetDouble
+#define RamRetDouble_t _RR_RETAINED_SECTION(RamRetDouble) RamRetDouble
 
 /**
- * @brief 	Macro for user user convenience when defining multiple __noinit variable of type RamRetDouble
+ * @brief 	Macro for user user convenience when defining multiple variables of type RamRetDouble in the ".ram_retained" section
  * @param [in] ... variable names to be defined.
  * @example 	RamRetDefineDouble(var1, var2, var3);
  */
@@ -215,13 +450,13 @@ RamRetTypeDeclare(double, RamRetDouble);
 RamRetTypeDeclare(uint8_t, RamRetUint8t);
 
 /**
- * @brief Macro for user user convenience when defining __noinit variable of type RamRetUint8t
+ * @brief Macro for user user convenience when defining a variable of type RamRetUint8t in the ".ram_retained" section
  * @example RamRetUint8_t foo;
  */
-#define RamRetUint8_t __noinit RamRetUint8t
+#define RamRetUint8_t _RR_RETAINED_SECTION(RamRetUint8t) RamRetUint8t
 
 /**
- * @brief 	Macro for user user convenience when defining multiple __noinit variable of type RamRetUint8t
+ * @brief 	Macro for user user convenience when defining multiple variables of type RamRetUint8t in the ".ram_retained" section
  * @param [in] ... variable names to be defined.
  * @example 	RamRetDefineUint8t(var1, var2, var3);
  */
@@ -245,13 +480,13 @@ RamRetTypeDeclare(uint8_t, RamRetUint8t);
 RamRetTypeDeclare(uint16_t, RamRetUint16t);
 
 /**
- * @brief Macro for user user convenience when defining __noinit variable of type RamRetUint16t
+ * @brief Macro for user user convenience when defining a variable of type RamRetUint16t in the ".ram_retained" section
  * @example RamRetUint16_t foo;
  */
-#define RamRetUint16_t __noinit RamRetUint16t
+#define RamRetUint16_t _RR_RETAINED_SECTION(RamRetUint16t) RamRetUint16t
 
 /**
- * @brief 	Macro for user user convenience when defining multiple __noinit variable of type RamRetUint16t
+ * @brief 	Macro for user user convenience when defining multiple variables of type RamRetUint16t in the ".ram_retained" section
  * @param [in] ... variable names to be defined.
  * @example 	RamRetDefineUint16t(var1, var2, var3);
  */
@@ -277,15 +512,16 @@ struct ramRetUint32t{
      uint32_t 	crc;
 };
 typedef struct ramRetUint32t RamRetUint32t;
+RamRetTypeIntegrity(RamRetUint32t, CRC32);
 
 /**
- * @brief Macro for user user convenience when defining __noinit variable of type RamRetUint32t
+ * @brief Macro for user user convenience when defining a variable of type RamRetUint32t in the ".ram_retained" section
  * @example RamRetUint32_t foo;
  */
-#define RamRetUint32_t __noinit RamRetUint32t
+#define RamRetUint32_t _RR_RETAINED_SECTION(RamRetUint32t) RamRetUint32t
 
 /**
- * @brief 	Macro for user user convenience when defining multiple __noinit variable of type RamRetUint32t
+ * @brief 	Macro for user user convenience when defining multiple variables of type RamRetUint32t in the ".ram_retained" section
  * @param [in] ... variable names to be defined.
  * @example 	RamRetDefineUint32t(var1, var2, var3);
  */
@@ -310,15 +546,16 @@ typedef struct ramRetUint64t{
 	uint64_t	rr_var;
 	uint32_t 	crc;
 }RamRetUint64t;
+RamRetTypeIntegrity(RamRetUint64t, CRC32);
 
 /**
- * @brief Macro for user user convenience when defining __noinit variable of type RamRetUint64t
+ * @brief Macro for user user convenience when defining a variable of type RamRetUint64t in the ".ram_retained" section
  * @example RamRetUint64_t foo;
  */
-#define RamRetUint64_t __noinit RamRetUint64t
+#define RamRetUint64_t _RR_RETAINED_SECTION(RamRetUint64t) RamRetUint64t
 
 /**
- * @brief 	Macro for user user convenience when defining multiple __noinit variable of type RamRetUint64t
+ * @brief 	Macro for user user convenience when defining multiple variables of type RamRetUint64t in the ".ram_retained" section
  * @param [in] ... variable names to be defined.
  * @example 	RamRetDefineUint64t(var1, var2, var3);
  */
@@ -342,13 +579,13 @@ typedef struct ramRetUint64t{
 RamRetTypeDeclare(int8_t, RamRetInt8t);
 
 /**
- * @brief Macro for user user convenience when defining __noinit variable of type RamRetInt8t
+ * @brief Macro for user user convenience when defining a variable of type RamRetInt8t in the ".ram_retained" section
  * @example RamRetInt8_t foo;
  */
-#define RamRetInt8_t __noinit RamRetInt8t
+#define RamRetInt8_t _RR_RETAINED_SECTION(RamRetInt8t) RamRetInt8t
 
 /**
- * @brief 	Macro for user user convenience when defining multiple __noinit variable of type RamRetInt8t
+ * @brief 	Macro for user user convenience when defining multiple variables of type RamRetInt8t in the ".ram_retained" section
  * @param [in] ... variable names to be defined.
  * @example 	RamRetDefineInt8t(var1, var2, var3);
  */
@@ -372,13 +609,13 @@ RamRetTypeDeclare(int8_t, RamRetInt8t);
 RamRetTypeDeclare(int16_t, RamRetInt16t);
 
 /**
- * @brief Macro for user user convenience when defining __noinit variable of type RamRetInt16t
+ * @brief Macro for user user convenience when defining a variable of type RamRetInt16t in the ".ram_retained" section
  * @example RamRetInt16_t foo;
  */
-#define RamRetInt16_t __noinit RamRetInt16t
+#define RamRetInt16_t _RR_RETAINED_SECTION(RamRetInt16t) RamRetInt16t
 
 /**
- * @brief 	Macro for user user convenience when defining multiple __noinit variable of type RamRetInt16t
+ * @brief 	Macro for user user convenience when defining multiple variables of type RamRetInt16t in the ".ram_retained" section
  * @param [in] ... variable names to be defined.
  * @example 	RamRetDefineInt16t(var1, var2, var3);
  */
@@ -402,13 +639,13 @@ RamRetTypeDeclare(int16_t, RamRetInt16t);
 RamRetTypeDeclare(int32_t, RamRetInt32t);
 
 /**
- * @brief Macro for user user convenience when defining __noinit variable of type RamRetInt32t
+ * @brief Macro for user user convenience when defining a variable of type RamRetInt32t in the ".ram_retained" section
  * @example RamRetInt32_t foo;
  */
-#define RamRetInt32_t __noinit RamRetInt32t
+#define RamRetInt32_t _RR_RETAINED_SECTION(RamRetInt32t) RamRetInt32t
 
 /**
- * @brief 	Macro for user user convenience when defining multiple __noinit variable of type RamRetInt32t
+ * @brief 	Macro for user user convenience when defining multiple variables of type RamRetInt32t in the ".ram_retained" section
  * @param [in] ... variable names to be defined.
  * @example 	RamRetDefineInt32t(var1, var2, var3);
  */
@@ -432,13 +669,13 @@ RamRetTypeDeclare(int32_t, RamRetInt32t);
 RamRetTypeDeclare(int64_t, RamRetInt64t);
 
 /**
- * @brief Macro for user user convenience when defining __noinit variable of type RamRetInt64t
+ * @brief Macro for user user convenience when defining a variable of type RamRetInt64t in the ".ram_retained" section
  * @example RamRetInt64_t foo;
  */
-#define RamRetInt64_t __noinit RamRetInt64t
+#define RamRetInt64_t _RR_RETAINED_SECTION(RamRetInt64t) RamRetInt64t
 
 /**
- * @brief 	Macro for user user convenience when defining multiple __noinit variable of type RamRetInt64t
+ * @brief 	Macro for user user convenience when defining multiple variables of type RamRetInt64t in the ".ram_retained" section
  * @param [in] ... variable names to be defined.
  * @example 	RamRetDefineInt64t(var1, var2, var3);
  */
@@ -462,13 +699,13 @@ RamRetTypeDeclare(int64_t, RamRetInt64t);
 RamRetTypeDeclare(atomic_t, RamRetAtomic);
 
 /**
- * @brief Macro for user user convenience when defining __noinit variable of type RamRetAtomic
+ * @brief Macro for user user convenience when defining a variable of type RamRetAtomic in the ".ram_retained" section
  * @example RamRetAtomic_t foo;
  */
-#define RamRetAtomic_t __noinit RamRetAtomic
+#define RamRetAtomic_t _RR_RETAINED_SECTION(RamRetAtomic) RamRetAtomic
 
 /**
- * @brief 	Macro for user user convenience when defining multiple __noinit variable of type RamRetAtomic
+ * @brief 	Macro for user user convenience when defining multiple variables of type RamRetAtomic in the ".ram_retained" section
  * @param [in] ... variable names to be defined.
  * @example 	RamRetDefineAtomic(var1, var2, var3);
  */
@@ -485,24 +722,341 @@ RamRetTypeDeclare(atomic_t, RamRetAtomic);
 
 
 
+/* atomic_t ram retention struct type with inverted copy check, declaration and helper macros */
+/** 
+ * @brief atomic_t user variable definition to be used with ram retention, checked with its inverted copy instead of a CRC.
+ * @note  Use the rr_atomic_*() functions for modifying it, they keep the check valid without locks and without computing a CRC.
+*/
+RamRetTypeDeclareIntegrity(atomic_t, RamRetAtomicInv, INVERTED);
+
+/**
+ * @brief Macro for user user convenience when defining a variable of type RamRetAtomicInv in the ".ram_retained" section
+ * @example RamRetAtomicInv_t foo;
+ */
+#define RamRetAtomicInv_t _RR_RETAINED_SECTION(RamRetAtomicInv) RamRetAtomicInv
+
+/**
+ * @brief 	Macro for user user convenience when defining multiple variables of type RamRetAtomicInv in the ".ram_retained" section
+ * @param [in] ... variable names to be defined.
+ * @example 	RamRetDefineAtomicInv(var1, var2, var3);
+ */
+#define RamRetDefineAtomicInv(...) RamRetDefineVars(RamRetAtomicInv, __VA_ARGS__)
+
+/**
+ * @brief 	Macro for user user convenience when externing multiple variables of type RamRetAtomicInv
+ * @param [in] ... variable names to be externed.
+ * @example 	RamRetExternAtomicInv(var1, var2, var3);
+ */
+#define RamRetExternAtomicInv(...) RamRetExternVars(RamRetAtomicInv, __VA_ARGS__)
+
+/**
+ * @brief INTERNAL. Make the check of a RamRetAtomicInv match its value after the value is changed atomically.
+ * @note  Rewritten until the value doesn't change under it, so when operations from ISRs nest, the outermost one leaves the check matching the final value.
+ *        Only a reset in the few instructions between the value update and this function leaves the variable invalid.
+*/
+static inline void _rr_atomic_check_update(RamRetAtomicInv * a_p_var)
+{
+	atomic_val_t value;
+
+	do {
+		value = atomic_get(&a_p_var->rr_var);
+		(void)atomic_set(&a_p_var->crc, ~value);
+	} while (atomic_get(&a_p_var->rr_var) != value);
+}
+
+/**
+ * @brief Atomically add to a RamRetAtomicInv and retain it. Safe from ISRs, lock-free.
+ * @return previous value
+*/
+static inline atomic_val_t rr_atomic_add(RamRetAtomicInv * a_p_var, atomic_val_t a_value)
+{
+	atomic_val_t old = atomic_add(&a_p_var->rr_var, a_value);
+
+	_rr_atomic_check_update(a_p_var);
+	return old;
+}
+
+/**
+ * @brief Atomically increment a RamRetAtomicInv and retain it. Safe from ISRs, lock-free.
+ * @return previous value
+*/
+static inline atomic_val_t rr_atomic_inc(RamRetAtomicInv * a_p_var)
+{
+	return rr_atomic_add(a_p_var, 1);
+}
+
+/**
+ * @brief Atomically set a RamRetAtomicInv and retain it. Safe from ISRs, lock-free.
+ * @return previous value
+*/
+static inline atomic_val_t rr_atomic_set(RamRetAtomicInv * a_p_var, atomic_val_t a_value)
+{
+	atomic_val_t old = atomic_set(&a_p_var->rr_var, a_value);
+
+	_rr_atomic_check_update(a_p_var);
+	return old;
+}
+
+/**
+ * @brief Atomic compare-and-set of a RamRetAtomicInv, retained if set. Safe from ISRs, lock-free.
+ * @return true if the value was a_old_value and is set to a_new_value, false if not.
+*/
+static inline bool rr_atomic_cas(RamRetAtomicInv * a_p_var, atomic_val_t a_old_value, atomic_val_t a_new_value)
+{
+	bool swapped = atomic_cas(&a_p_var->rr_var, a_old_value, a_new_value);
+
+	if (swapped) {
+		_rr_atomic_check_update(a_p_var);
+	}
+	return swapped;
+}
+
+/**
+ * @brief Atomically read a RamRetAtomicInv.
+*/
+static inline atomic_val_t rr_atomic_get(const RamRetAtomicInv * a_p_var)
+{
+	return atomic_get(&a_p_var->rr_var);
+}
+
+
+
+
+
+/**
+ * @brief Number of RAM blocks with retention control, depends on the backend (CONFIG_APP_RETENTION_BACKEND).
+ *        nRF52: 8 blocks with two 4 KiB sections and a 9th block with 32 KiB sections. nRF5340: 8 blocks with sixteen 4 KiB sections.
+ *        nRF54L and no retention control: a single block.
+*/
+#if defined(CONFIG_APP_RETENTION_BACKEND_VMC)
+#define RR_RAM_BLOCK_COUNT 8
+#elif defined(CONFIG_APP_RETENTION_BACKEND_MEMCONF) || defined(CONFIG_APP_RETENTION_BACKEND_NONE)
+#define RR_RAM_BLOCK_COUNT 1
+#else
+#define RR_RAM_BLOCK_COUNT 9
+#endif
+
+/**
+ * @brief Address range of a retainable object, used with ram_ranges_retain().
+*/
+struct ramRetRange{
+	const void *	ptr;			// pointer to the start of the retainable object
+	size_t		len;			// length of the retainable object
+};
+
+/**
+ * @brief Cycle counts of a registered ram retention variable, measured with the DWT cycle counter (CONFIG_APP_RETENTION_STATS).
+ * @note  Only commits through the macros and functions taking the variable name or descriptor are counted, i.e. RR_Var_Ram_Ret_Defer(),
+ *        RR_Var_Ram_Ret_Many() and ram_retained_flush(). RR_Var_Ram_Ret() only knows the address of the variable.
+*/
+struct ramRetStats{
+	uint32_t	validate_cycles;	// cycles of the validation at boot or at first access, including the reset if it wasn't valid
+	uint32_t	commit_count;		// number of commits
+	uint32_t	commit_min;		// fewest cycles of a commit, valid if commit_count isn't 0
+	uint32_t	commit_max;		// most cycles of a commit
+	uint64_t	commit_total;		// cycles of all commits, average is commit_total / commit_count
+	uint32_t	crc_failures;		// number of failed validations
+	uint32_t	ecc_repairs;		// number of validations repaired by RR_INTEGRITY_ECC
+};
+
+/**
+ * @brief Cycle counts of the boot time validation pass (CONFIG_APP_RETENTION_STATS).
+*/
+struct ramRetBootStats{
+	uint32_t	pass_cycles;		// cycles of the whole boot pass
+	uint32_t	retain_cycles;		// cycles of setting the RAM retention registers
+};
+
+/**
+ * @brief INTERNAL. Statistics of a registered variable, only with CONFIG_APP_RETENTION_STATS.
+*/
+#if defined(CONFIG_APP_RETENTION_STATS)
+#define _RR_STATS_DEFINE(rr_var_name) static struct ramRetStats rr_var_name##_rr_stats;
+#define _RR_STATS_INIT(rr_var_name) .stats = &rr_var_name##_rr_stats,
+#else
+#define _RR_STATS_DEFINE(rr_var_name)
+#define _RR_STATS_INIT(rr_var_name)
+#endif
+
+/**
+ * @brief Descriptor of a ram retention variable that is registered for the common boot time validation pass.
+ * @note  Descriptors are placed in a Zephyr iterable section by RR_Init_Var_Ram_Retention(), user normally doesn't need to create them.
+*/
+struct ramRetDescriptor{
+	void *		addr;			// address of the ram retention variable
+	size_t		size;			// sizeof the ram retention variable
+	size_t		crc_offset;		// offsetof the crc variable of the ram retention type, size of an entry for RR_INTEGRITY_RING
+	const char *	name;			// name of the ram retention variable, used for logging
+	atomic_t *	state;			// runtime state flags of the ram retention variable, enum ramRetStateFlags
+	const void *	defaults;		// value copied in when the variable isn't valid, in flash. NULL for zero
+	bool		lazy;			// validated at first access instead of at boot, see RR_Init_Var_Ram_Retention_Lazy()
+	uint32_t	layout;			// layout hash of a type declared with RamRetTypeDeclareLayout(), 0 for other types
+#if defined(CONFIG_APP_RETENTION_STATS)
+	struct ramRetStats *	stats;		// cycle counts of the ram retention variable
+#endif
+	uint8_t		integrity;		// integrity check algorithm of the ram retention type, enum ramRetIntegrity
+};
+typedef struct ramRetDescriptor RamRetDescriptor;
+
+/**
+ * @brief Bits of the runtime state flags of a registered ram retention variable. Runtime state isn't retained.
+*/
+enum ramRetStateFlags{
+	RR_STATE_DIRTY = 0,			// variable is changed but its crc isn't updated yet, see RR_Var_Ram_Ret_Defer()
+	RR_STATE_VALIDATED,			// variable is validated, by the boot pass or by the first RR_Var_Access() if it is lazy
+	RR_STATE_UNSAVED,			// variable is committed but not written to flash yet, see CONFIG_APP_RETENTION_SPILL
+};
+
+/**
+ * @brief INTERNAL. Places a variable into the dedicated ".ram_retained" linker section, so that all retained variables are kept together.
+*/
+#define _RR_RETAINED_SECTION(var_name) __attribute__((__section__(".ram_retained." STRINGIFY(var_name))))
+
+/**
+ * @brief INTERNAL. Define a variable in the ".ram_retained" section and register its descriptor.
+ * @param [in] rr_defaults pointer to the default value of the variable in flash, NULL for zero.
+ * @param [in] rr_lazy     true if the variable is validated at first access.
+*/
+#define _RR_Define_Registered(rr_var_type, rr_var_name, rr_defaults, rr_lazy)		\
+			_RR_RETAINED_SECTION(rr_var_name) rr_var_type rr_var_name;	\
+			atomic_t rr_var_name##_rr_state;					\
+			_RR_STATS_DEFINE(rr_var_name)						\
+			const STRUCT_SECTION_ITERABLE(ramRetDescriptor, _rr_desc_##rr_var_name) = {	\
+				.addr		= &rr_var_name,					\
+				.size		= sizeof(rr_var_type),				\
+				.crc_offset	= offsetof(rr_var_type, crc),			\
+				.name		= #rr_var_name,					\
+				.state		= &rr_var_name##_rr_state,			\
+				_RR_STATS_INIT(rr_var_name)					\
+				.defaults	= rr_defaults,					\
+				.lazy		= rr_lazy,					\
+				.layout		= _RR_TYPE_LAYOUT(rr_var_type),			\
+				.integrity	= _RR_TYPE_INTEGRITY(rr_var_type),		\
+			}
+
+/**
+ * @brief INTERNAL. Define the default value of a variable in flash and register the variable with it.
+*/
+#define _RR_Define_Registered_Default(rr_var_type, rr_var_name, rr_lazy, ...)		\
+			BUILD_ASSERT((_RR_TYPE_INTEGRITY(rr_var_type) != RR_INTEGRITY_AB) &&		\
+				     (_RR_TYPE_INTEGRITY(rr_var_type) != RR_INTEGRITY_RING),		\
+				     "default values are only supported for types with a single rr_var");	\
+			static const rr_var_type _rr_default_##rr_var_name = { .rr_var = __VA_ARGS__ };	\
+			_RR_Define_Registered(rr_var_type, rr_var_name, &_rr_default_##rr_var_name, rr_lazy)
+
+
+
 /**
  * @brief Define and initialize a ram retention variable. This macro is created so that definition and initialization can be done with 1 line of code. 
- * @note This macro utilizes SYS_INIT infrastructure internally and creates a unique initialization function for every call for the macro.
+ * @note This macro places the variable into the ".ram_retained" linker section and registers it for the boot time validation pass.
+ *       All registered variables are validated and retained by a single SYS_INIT function (APPLICATION level, priority 30), so no initialization function is created per variable.
+ * @note An optional default value of rr_var can be given, it is kept in flash and copied in when the variable isn't valid (i.e. at first power up).
+ *       Without it the variable is set to zero. The restored value is committed, no default fixup code is needed after a reset.
  * @note If need arises that another type of variable is used and that type isn't readily available, it first must be declared using RamRetTypeDeclare(var_type, typedef_name) macro.
- * @note If a error occurs at initialization, logging must be enabled and registered at the caller file to see the error message.
+ * @note If a error occurs at initialization, logging must be enabled to see the error message.
  * @param [in] rr_var_type type of the variable i.e. RamRetInt
  * @param [in] rr_var_name given name for the variable
+ * @param [in] ...         optional, initializer of the default value of rr_var, i.e. 8 or { .foo = 5, .baz = { 1, 2 } }
+ * @example  RR_Init_Var_Ram_Retention(RamRetInt, g_retries, 3);
 */
-#define RR_Init_Var_Ram_Retention(rr_var_type, rr_var_name) 	\
-			RamRetVarDefine(rr_var_type, rr_var_name);		\
-			SYS_INIT_SIMPLE(APPLICATION, 30)				\
-			{										\
-				bool is_valid = ram_retained_validate(&rr_var_name, (size_t)sizeof(rr_var_name), (size_t)offsetof(rr_var_type, crc), (size_t)sizeof(rr_var_name.crc));			 	\
-				if(false == is_valid){					\
-					LOG_ERR("Ram ret initialization error at SYS_INIT of variable <%s %s>", #rr_var_type, #rr_var_name); 	\
-				}									\
-				return 0;								\
-			}			
+#define RR_Init_Var_Ram_Retention(rr_var_type, rr_var_name, ...) 	\
+			COND_CODE_1(IS_EMPTY(__VA_ARGS__),					\
+				    (_RR_Define_Registered(rr_var_type, rr_var_name, NULL, false)),	\
+				    (_RR_Define_Registered_Default(rr_var_type, rr_var_name, false, __VA_ARGS__)))
+
+
+
+/**
+ * @brief Same as RR_Init_Var_Ram_Retention() but the variable is validated at its first access with RR_Var_Access() instead of at boot.
+ * @note  Retention of the variable is still enabled at boot. Useful for rarely used variables (i.e. diagnostic data) whose CRC
+ *        would slow down the boot.
+ * @warning Variable must be accessed only through RR_Var_Access(). Until the first access, it isn't committed by the
+ *          deferred commit or batch commit functions.
+ * @param [in] rr_var_type type of the variable i.e. RamRetInt
+ * @param [in] rr_var_name given name for the variable
+ * @param [in] ...         optional, initializer of the default value of rr_var.
+*/
+#define RR_Init_Var_Ram_Retention_Lazy(rr_var_type, rr_var_name, ...) 	\
+			COND_CODE_1(IS_EMPTY(__VA_ARGS__),					\
+				    (_RR_Define_Registered(rr_var_type, rr_var_name, NULL, true)),	\
+				    (_RR_Define_Registered_Default(rr_var_type, rr_var_name, true, __VA_ARGS__)))
+
+/**
+ * @brief Pointer to a variable defined with RR_Init_Var_Ram_Retention(), validated first if it is lazy and not validated yet.
+ * @note  First access of a lazy variable checks it (and resets it if it isn't valid) with IRQs locked, later accesses only test a bit.
+ * @param [in] rr_var_name ram retention type variable's name.
+ * @example  RR_Var_Access(g_diag)->rr_var.count++;
+*/
+#define RR_Var_Access(rr_var_name) 									\
+		((__typeof__(rr_var_name) *)ram_retained_access(&_rr_desc_##rr_var_name))
+
+
+
+
+
+/**
+ * @brief Declare an extern ram retention variable that is defined with RR_Init_Var_Ram_Retention() in some other file, together with its registry entries.
+ * @note  Use this instead of RamRetVarExtern() when the variable is used with macros taking the variable name, i.e. RR_Var_Ram_Ret_Defer().
+ * @param [in] rr_var_type type of the variable i.e. RamRetInt
+ * @param [in] rr_var_name variable's name
+*/
+#define RR_Extern_Var_Ram_Retention(rr_var_type, rr_var_name) 		\
+			extern rr_var_type rr_var_name;					\
+			extern atomic_t rr_var_name##_rr_state;				\
+			extern const struct ramRetDescriptor _rr_desc_##rr_var_name
+
+
+
+
+/**
+ * @brief Migration function of a variable whose type is declared with RamRetTypeDeclareLayout(), see RR_Var_Migration_Define().
+ * @param [in] a_p_retained_var pointer to the ram retention variable, it still holds the bytes retained by the previous firmware and
+ *                              they pass the CRC-32 of the previous layout.
+ * @param [in] a_old_layout     layout hash found in the rr_layout header, the old layout the migration is registered for.
+ * @return true if the data is converted to the current layout in place, false if the variable is reset.
+*/
+typedef bool (*ram_retained_migrate_t)(void * a_p_retained_var, uint32_t a_old_layout);
+
+/**
+ * @brief Migration function of a registered variable from one previous layout, created by RR_Var_Migration_Define().
+*/
+struct ramRetMigration{
+	const struct ramRetDescriptor *	desc;		// descriptor of the variable
+	ram_retained_migrate_t		migrate;	// migration function of the variable
+	uint32_t			old_layout;	// layout hash of the previous firmware, RR_Var_Layout() printed by it
+	size_t				old_crc_offset;	// crc offset of the previous layout, offsetof() crc in the type of the previous firmware
+};
+
+/**
+ * @brief Register the migration function of a variable defined with RR_Init_Var_Ram_Retention(), whose type is declared with RamRetTypeDeclareLayout(),
+ *        from one previous layout. A variable can have one registration per previous layout.
+ *        When the layout header of the variable holds rr_old_layout, the boot pass checks the CRC-32 of the previous layout at rr_old_crc_offset
+ *        and calls migrate_fn only if it is valid. Its CRC and layout header are updated by the library after a successful migration.
+ * @note  Data of the previous firmware is at the address of the variable in the current firmware. Address is kept as long as the
+ *        variable takes as many slots of CONFIG_APP_RETENTION_LAYOUT_SLOT_SIZE as before and no variable of a type with a layout header
+ *        is added or removed before it in name order, see RamRetTypeDeclareLayout().
+ * @param [in] rr_var_name       ram retention type variable's name.
+ * @param [in] rr_old_layout     layout hash of the previous firmware, RR_Var_Layout() of the variable in it
+ * @param [in] rr_old_crc_offset crc offset of the previous layout, offsetof(<previous ram retention type>, crc)
+ * @param [in] migrate_fn        function of type ram_retained_migrate_t
+ * @example  RR_Var_Migration_Define(g_settings, 0x3a7c90e5, 24, settings_from_v1);
+*/
+#define RR_Var_Migration_Define(rr_var_name, rr_old_layout, rr_old_crc_offset, migrate_fn)			\
+			BUILD_ASSERT(((rr_old_crc_offset) % sizeof(uint32_t) == 0) &&				\
+				     ((rr_old_crc_offset) + sizeof(uint32_t) <= sizeof(rr_var_name)),		\
+				     "previous layout of " #rr_var_name " doesn't fit in its slots");		\
+			const STRUCT_SECTION_ITERABLE(ramRetMigration, UTIL_CAT(_rr_migration_##rr_var_name##_, __COUNTER__)) = {	\
+				.desc		= &_rr_desc_##rr_var_name,			\
+				.migrate	= migrate_fn,					\
+				.old_layout	= rr_old_layout,				\
+				.old_crc_offset	= rr_old_crc_offset,			\
+			}
+
+/**
+ * @brief Layout hash of a variable defined with RR_Init_Var_Ram_Retention(), 0 if its type has no layout header. Value to be given
+ *        to the migration function of the next firmware as a_old_layout.
+*/
+#define RR_Var_Layout(rr_var_name) (_rr_desc_##rr_var_name.layout)
 
 
 
@@ -511,6 +1065,7 @@ RamRetTypeDeclare(atomic_t, RamRetAtomic);
 /**
  * @brief Similar to RR_Init_Var_Ram_Retention(rr_var_type, rr_var_name). Define and initialize a ram retention variable and also configure SYS_INIT parameters. 
  * @note  check RR_Init_Var_Ram_Retention(rr_var_type, rr_var_name) macro for additional notes.
+ * @note  Variable is placed into the ".ram_retained" linker section but isn't registered for the common boot time validation pass. This macro utilizes SYS_INIT infrastructure internally and creates a unique initialization function for every call for the macro.
  * @note  If a error occurs at initialization, logging must be enabled and registered at the caller file to see the error message.
  * @param [in] rr_var_type type of the variable i.e. RamRetInt
  * @param [in] rr_var_name given name for the variable
@@ -518,10 +1073,10 @@ RamRetTypeDeclare(atomic_t, RamRetAtomic);
  * @param [in] prio       Initialization priority of SYS_INIT()	  @defgroup   initialization_priority 	at sys_init_utils.h	
 */
 #define RR_Init_Var_Ram_Retention_Conf(rr_var_type, rr_var_name, level, prio) 	\
-			RamRetVarDefine(rr_var_type, rr_var_name);		\
+			_RR_RETAINED_SECTION(rr_var_name) rr_var_type rr_var_name;		\
 			SYS_INIT_SIMPLE(level, prio)					\
 			{										\
-				bool is_valid = ram_retained_validate(&rr_var_name, (size_t)sizeof(rr_var_name), (size_t)offsetof(rr_var_type, crc), (size_t)sizeof(rr_var_name.crc));			 \
+				bool is_valid = ram_retained_validate_integrity(_RR_TYPE_INTEGRITY(rr_var_type), &rr_var_name, (size_t)sizeof(rr_var_name), (size_t)offsetof(rr_var_type, crc));			 \
 				if(false == is_valid){					\
 					LOG_ERR("Ram ret initialization error at SYS_INIT of variable <%s %s>", #rr_var_type, #rr_var_name); 	\
 				}									\
@@ -532,11 +1087,279 @@ RamRetTypeDeclare(atomic_t, RamRetAtomic);
 
 /**
  * @brief After operating on some ram retention variable in any way that would cause it to change, you need to call void RR_Var_Ram_Retain(void * a_p_retained_var, size_t a_retained_crc_offset) function. But this macro can be used instead in place of the function if more convenient, since the parameters it takes is more straightforward.
+ * @note  Integrity check algorithm is taken from the type (see RamRetTypeDeclareIntegrity()), the matching routine is called directly.
  * @param [in] rr_var_type type of the variable i.e. RamRetInt
  * @param [in] rr_var_addr address of the ram retention type variable
 */
 #define RR_Var_Ram_Ret(rr_var_type, rr_var_addr) 							\
-		RR_Var_Ram_Retain(rr_var_addr, (size_t)offsetof(rr_var_type, crc)) 
+		ram_retained_update_integrity(_RR_TYPE_INTEGRITY(rr_var_type), rr_var_addr, (size_t)offsetof(rr_var_type, crc)) 
+
+
+
+/**
+ * @brief Retain a variable defined with RR_Init_Var_Ram_Retention() after modifying it, deferred if CONFIG_APP_RETENTION_DEFERRED_COMMIT is enabled.
+ * @note  With CONFIG_APP_RETENTION_DEFERRED_COMMIT=y the variable is only marked dirty, which is cheap and safe from ISRs.
+ *        CRCs of all dirty variables are updated in one batch by ram_retained_flush(), which is called before reboot, on fatal errors,
+ *        before System OFF and optionally periodically (see Kconfig). Without it, this macro is the same as RR_Var_Ram_Ret().
+ * @warning Changes of a dirty variable are lost if the reset isn't one of the above (i.e. pin reset, watchdog).
+ * @param [in] rr_var_type type of the variable i.e. RamRetInt
+ * @param [in] rr_var_name ram retention type variable's name.
+*/
+#if defined(CONFIG_APP_RETENTION_DEFERRED_COMMIT)
+#define RR_Var_Ram_Ret_Defer(rr_var_type, rr_var_name) 						\
+		atomic_set_bit(&rr_var_name##_rr_state, RR_STATE_DIRTY)
+#elif defined(CONFIG_APP_RETENTION_STATS) || defined(CONFIG_APP_RETENTION_SPILL)
+#define RR_Var_Ram_Ret_Defer(rr_var_type, rr_var_name) 						\
+		ram_retained_update_descs(&_rr_desc_##rr_var_name, 1)
+#else
+#define RR_Var_Ram_Ret_Defer(rr_var_type, rr_var_name) 						\
+		RR_Var_Ram_Ret(rr_var_type, &(rr_var_name))
+#endif
+
+
+
+/**
+ * @brief INTERNAL. needed for using with FOR_EACH
+*/
+#define _RR_Desc_Addr(rr_var_name) &_rr_desc_##rr_var_name
+
+/**
+ * @brief Retain many variables defined with RR_Init_Var_Ram_Retention() after modifying them, in one pass and in a single IRQ lock window.
+ * @note  Variables can have different types, the type of each one is taken from its descriptor. Dirty marks of the variables are cleared.
+ * @note  Variables defined in other files must be declared with RR_Extern_Var_Ram_Retention().
+ * @param [in] ... ram retention type variable names, separated using commas.
+ * @example  RR_Var_Ram_Ret_Many(g_cnt, g_custom);
+*/
+#define RR_Var_Ram_Ret_Many(...) 										\
+		do {												\
+			const struct ramRetDescriptor *const _rr_descs[] = {					\
+				FOR_EACH(_RR_Desc_Addr, (,), __VA_ARGS__)					\
+			};											\
+			ram_retained_update_many(_rr_descs, ARRAY_SIZE(_rr_descs));				\
+		} while (0)
+
+
+
+/**
+ * @brief Write the value of a ram retention variable declared with RamRetTypeDeclareSeq() and retain it, tear-free for concurrent readers.
+ * @note  Lock-free, doesn't block: if another write of the same variable is in progress (i.e. the caller preempted it), nothing is written.
+ * @param [in] rr_var_type type of the variable i.e. RamRetMySeqType
+ * @param [in] rr_var_addr address of the ram retention type variable
+ * @param [in] p_value     pointer to the new value, same type as rr_var
+ * @retval 0 on success, -EBUSY if another write is in progress.
+*/
+#define RR_Seq_Write(rr_var_type, rr_var_addr, p_value) 							\
+		({												\
+			BUILD_ASSERT(sizeof(*(p_value)) == sizeof(((rr_var_type *)0)->rr_var),		\
+				     "value type doesn't match the ram retention type");			\
+			ram_retained_seq_write(rr_var_addr, (size_t)offsetof(rr_var_type, rr_var), p_value,	\
+					       sizeof(((rr_var_type *)0)->rr_var),				\
+					       (size_t)offsetof(rr_var_type, crc));				\
+		})
+
+/**
+ * @brief Read a consistent copy of the value of a ram retention variable declared with RamRetTypeDeclareSeq().
+ * @note  Lock-free, doesn't block: if a write of the variable is in progress (i.e. the caller preempted it), nothing is read.
+ * @param [in]  rr_var_type type of the variable i.e. RamRetMySeqType
+ * @param [in]  rr_var_addr address of the ram retention type variable
+ * @param [out] p_value     pointer to the copy, same type as rr_var
+ * @retval 0 on success, -EBUSY if a write is in progress.
+*/
+#define RR_Seq_Read(rr_var_type, rr_var_addr, p_value) 							\
+		({												\
+			BUILD_ASSERT(sizeof(*(p_value)) == sizeof(((rr_var_type *)0)->rr_var),		\
+				     "value type doesn't match the ram retention type");			\
+			ram_retained_seq_read(rr_var_addr, (size_t)offsetof(rr_var_type, rr_var), p_value,	\
+					      sizeof(((rr_var_type *)0)->rr_var));				\
+		})
+
+
+
+/**
+ * @brief INTERNAL. Size of one slot of a ram retention type declared with RamRetTypeDeclareAB().
+*/
+#define _RR_AB_SLOT_SIZE(rr_var_type) sizeof(((rr_var_type *)0)->rr_slot[0])
+
+/**
+ * @brief Commit a new value to a ram retention variable declared with RamRetTypeDeclareAB().
+ * @note  Lock-free, doesn't block: if another write of the same variable is in progress (i.e. the caller preempted it), nothing is written.
+ * @param [in] rr_var_type type of the variable i.e. RamRetMyABType
+ * @param [in] rr_var_addr address of the ram retention type variable
+ * @param [in] p_value     pointer to the new value, same type as rr_var
+ * @retval 0 on success, -EBUSY if another write is in progress.
+*/
+#define RR_AB_Write(rr_var_type, rr_var_addr, p_value) 							\
+		({												\
+			BUILD_ASSERT(_RR_TYPE_INTEGRITY(rr_var_type) == RR_INTEGRITY_AB,			\
+				     "RR_AB_Write() needs a type declared with RamRetTypeDeclareAB()");	\
+			BUILD_ASSERT(sizeof(*(p_value)) == sizeof(((rr_var_type *)0)->rr_slot[0].rr_var),	\
+				     "value type doesn't match the ram retention type");			\
+			ram_retained_ab_write(rr_var_addr, (size_t)offsetof(rr_var_type, rr_slot[0].rr_var), p_value,	\
+					      sizeof(((rr_var_type *)0)->rr_slot[0].rr_var),			\
+					      _RR_AB_SLOT_SIZE(rr_var_type));				\
+		})
+
+/**
+ * @brief Read a consistent copy of the newest value of a ram retention variable declared with RamRetTypeDeclareAB().
+ * @note  Lock-free and never fails, a write in progress only affects the inactive slot.
+ * @param [in]  rr_var_type type of the variable i.e. RamRetMyABType
+ * @param [in]  rr_var_addr address of the ram retention type variable
+ * @param [out] p_value     pointer to the copy, same type as rr_var
+*/
+#define RR_AB_Read(rr_var_type, rr_var_addr, p_value) 							\
+		do {												\
+			BUILD_ASSERT(_RR_TYPE_INTEGRITY(rr_var_type) == RR_INTEGRITY_AB,			\
+				     "RR_AB_Read() needs a type declared with RamRetTypeDeclareAB()");		\
+			BUILD_ASSERT(sizeof(*(p_value)) == sizeof(((rr_var_type *)0)->rr_slot[0].rr_var),	\
+				     "value type doesn't match the ram retention type");			\
+			ram_retained_ab_read(rr_var_addr, (size_t)offsetof(rr_var_type, rr_slot[0].rr_var), p_value,	\
+					     sizeof(((rr_var_type *)0)->rr_slot[0].rr_var),			\
+					     _RR_AB_SLOT_SIZE(rr_var_type));				\
+		} while (0)
+
+
+
+/**
+ * @brief INTERNAL. Size of one entry slot and capacity of a ram retention type declared with RamRetTypeDeclareRing().
+*/
+#define _RR_RING_STRIDE(rr_var_type) sizeof(((rr_var_type *)0)->rr_entries[0])
+#define _RR_RING_CAPACITY(rr_var_type) ARRAY_SIZE(((rr_var_type *)0)->rr_entries)
+
+/**
+ * @brief Define a ram retention ring buffer of a type declared with RamRetTypeDeclareRing() and register it for the boot time repair pass.
+ * @note  Same as RR_Init_Var_Ram_Retention() otherwise, variable defined in other files can be declared with RR_Extern_Var_Ram_Retention().
+ * @param [in] rr_var_type type of the variable i.e. RamRetMyEventRing
+ * @param [in] rr_var_name given name for the variable
+*/
+#define RR_Ring_Define(rr_var_type, rr_var_name)						\
+			BUILD_ASSERT(_RR_TYPE_INTEGRITY(rr_var_type) == RR_INTEGRITY_RING,		\
+				     "RR_Ring_Define() needs a type declared with RamRetTypeDeclareRing()");	\
+			_RR_RETAINED_SECTION(rr_var_name) rr_var_type rr_var_name;	\
+			atomic_t rr_var_name##_rr_state;					\
+			_RR_STATS_DEFINE(rr_var_name)						\
+			const STRUCT_SECTION_ITERABLE(ramRetDescriptor, _rr_desc_##rr_var_name) = {	\
+				.addr		= &rr_var_name,					\
+				.size		= sizeof(rr_var_type),				\
+				.crc_offset	= _RR_RING_STRIDE(rr_var_type),			\
+				.name		= #rr_var_name,					\
+				.state		= &rr_var_name##_rr_state,			\
+				_RR_STATS_INIT(rr_var_name)					\
+				.integrity	= RR_INTEGRITY_RING,				\
+			}
+
+/**
+ * @brief Append an entry to a ram retention ring buffer, oldest entry is overwritten. Lock-free, safe from ISRs.
+ * @param [in] rr_var_type type of the variable i.e. RamRetMyEventRing
+ * @param [in] rr_var_addr address of the ram retention type variable
+ * @param [in] p_entry     pointer to the new entry, same type as rr_entry
+ * @return sequence number of the appended entry, uint32_t.
+*/
+#define RR_Ring_Append(rr_var_type, rr_var_addr, p_entry) 							\
+		({												\
+			BUILD_ASSERT(sizeof(*(p_entry)) == sizeof(((rr_var_type *)0)->rr_entries[0].rr_entry),	\
+				     "entry type doesn't match the ram retention type");			\
+			ram_retained_ring_append(rr_var_addr, (size_t)offsetof(rr_var_type, rr_entries[0].rr_entry),	\
+						 p_entry, sizeof(*(p_entry)),					\
+						 _RR_RING_STRIDE(rr_var_type), _RR_RING_CAPACITY(rr_var_type));	\
+		})
+
+/**
+ * @brief Call a function for every valid entry of a ram retention ring buffer, oldest first.
+ * @param [in] rr_var_type type of the variable i.e. RamRetMyEventRing
+ * @param [in] rr_var_addr address of the ram retention type variable
+ * @param [in] cb          ram_retained_ring_cb_t, called with the sequence number and a pointer to the entry
+ * @param [in] user_data   passed to cb
+ * @return number of valid entries, size_t.
+*/
+#define RR_Ring_Foreach(rr_var_type, rr_var_addr, cb, user_data) 						\
+		ram_retained_ring_foreach(rr_var_addr, (size_t)offsetof(rr_var_type, rr_entries[0].rr_entry),	\
+					  _RR_RING_STRIDE(rr_var_type), _RR_RING_CAPACITY(rr_var_type), cb, user_data)
+
+
+
+/**
+ * @brief Set one field of a CRC-32 checked ram retention variable and retain it, without recomputing the CRC of the whole variable.
+ *        CRC is patched from the old value, the new value and the field offset, so the cost depends only on the field size.
+ * @note  The value is set by the macro because the old value is needed for patching the CRC.
+ * @note  CRC of the variable must be valid before (i.e. it is initialized or retained with RR_Var_Ram_Ret()), otherwise it stays invalid.
+ * @param [in] rr_var_type type of the variable i.e. RamRetMyCustomData. Must be checked with CRC-32.
+ * @param [in] rr_var_name ram retention type variable's name.
+ * @param [in] field       field of rr_var to be set, i.e. foo or baz[3]
+ * @param [in] value       new value of the field
+ * @example  RR_Var_Ram_Ret_Field(RamRetMyCustomData, g_custom, foo, g_custom.rr_var.foo + 5);
+*/
+#define RR_Var_Ram_Ret_Field(rr_var_type, rr_var_name, field, value) 					\
+		do {												\
+			BUILD_ASSERT(_RR_TYPE_INTEGRITY(rr_var_type) == RR_INTEGRITY_CRC32,			\
+				     "RR_Var_Ram_Ret_Field() needs a CRC-32 checked type");			\
+			__typeof__((rr_var_name).rr_var.field) _rr_new_value = (value);				\
+			ram_retained_update_field(&(rr_var_name), (size_t)offsetof(rr_var_type, crc),		\
+						  (size_t)offsetof(rr_var_type, rr_var.field),			\
+						  &_rr_new_value, sizeof(_rr_new_value));			\
+		} while (0)
+
+
+
+/**
+ * @brief Read a field of a ram retention group declared with RamRetTypeDeclareGroup(). Value has the type of the field.
+ * @param [in] rr_var_name ram retention type variable's name.
+ * @param [in] field       field of the group, i.e. boot_count
+*/
+#define RR_Group_Get(rr_var_name, field) ((rr_var_name).rr_var.field)
+
+/**
+ * @brief Set a field of a ram retention group declared with RamRetTypeDeclareGroup() and retain it, the CRC of the group is patched.
+ * @note  Setting many fields at once is cheaper by writing them with rr_var_name.rr_var.field and committing with RR_Var_Ram_Ret() once.
+ * @param [in] rr_var_type type of the variable i.e. RamRetMyGroup
+ * @param [in] rr_var_name ram retention type variable's name.
+ * @param [in] field       field of the group, i.e. boot_count
+ * @param [in] value       new value of the field
+*/
+#define RR_Group_Set(rr_var_type, rr_var_name, field, value) 						\
+		RR_Var_Ram_Ret_Field(rr_var_type, rr_var_name, field, value)
+
+
+
+/**
+ * @brief Set a flag of a ram retention bitset declared with RamRetTypeDeclareBitset() and mark it configured. Lock-free, safe from ISRs.
+ * @note  CRC of the bitset must be valid before (i.e. it is initialized with RR_Init_Var_Ram_Retention()), otherwise it stays invalid.
+ * @param [in] rr_var_type type of the variable i.e. RamRetFeatureFlags
+ * @param [in] rr_var_name ram retention type variable's name.
+ * @param [in] bit         index of the flag
+ * @param [in] value       new value of the flag
+*/
+#define RR_Bitset_Set(rr_var_type, rr_var_name, bit, value) 						\
+		ram_retained_bitset_set(&(rr_var_name), (size_t)offsetof(rr_var_type, rr_configured),	\
+					(size_t)offsetof(rr_var_type, crc), bit, value)
+
+/**
+ * @brief Return a flag of a ram retention bitset to its default value, it isn't configured anymore. Lock-free, safe from ISRs.
+ * @param [in] rr_var_type type of the variable i.e. RamRetFeatureFlags
+ * @param [in] rr_var_name ram retention type variable's name.
+ * @param [in] bit         index of the flag
+*/
+#define RR_Bitset_Unset(rr_var_type, rr_var_name, bit) 							\
+		ram_retained_bitset_unset(&(rr_var_name), (size_t)offsetof(rr_var_type, rr_configured),	\
+					  (size_t)offsetof(rr_var_type, crc), bit)
+
+/**
+ * @brief Value of a flag of a ram retention bitset, false if it isn't configured.
+*/
+#define RR_Bitset_Test(rr_var_name, bit) atomic_test_bit((rr_var_name).rr_bits, bit)
+
+/**
+ * @brief true if a flag of a ram retention bitset is configured with RR_Bitset_Set().
+*/
+#define RR_Bitset_Is_Configured(rr_var_name, bit) atomic_test_bit((rr_var_name).rr_configured, bit)
+
+/**
+ * @brief Value of a flag of a ram retention bitset, or its default value if it isn't configured.
+ * @param [in] rr_var_name   ram retention type variable's name.
+ * @param [in] bit           index of the flag
+ * @param [in] default_value value of the flag until it is configured
+*/
+#define RR_Bitset_Get(rr_var_name, bit, default_value) 							\
+		(RR_Bitset_Is_Configured(rr_var_name, bit) ? RR_Bitset_Test(rr_var_name, bit) : (bool)(default_value))
 
 
 
@@ -548,7 +1371,7 @@ RamRetTypeDeclare(atomic_t, RamRetAtomic);
  * @retval true if ram retain successful, false if not.
 */
 #define RR_Var_Ram_Ret_Init(rr_var_type, rr_var_name) 							\
-		ram_retained_validate(&rr_var_name, (size_t)sizeof(rr_var_name), (size_t)offsetof(rr_var_type, crc), (size_t)sizeof(rr_var_name.crc))
+		ram_retained_validate_integrity(_RR_TYPE_INTEGRITY(rr_var_type), &rr_var_name, (size_t)sizeof(rr_var_name), (size_t)offsetof(rr_var_type, crc))
 
 
 
@@ -558,8 +1381,102 @@ RamRetTypeDeclare(atomic_t, RamRetAtomic);
 
 // only for testing purposes, user normally shouldn't try to use these
 bool ram_retained_validate(void * a_var_ptr, size_t a_var_size, size_t a_retained_crc_offset, size_t a_sizeof_retained_crc );
+bool ram_retained_check(const void * a_retained_var_ptr, size_t a_checked_size);
 void ram_retained_update(void * a_p_retained_var, size_t a_retained_crc_offset);
+void ram_retained_update_field(void * a_p_retained_var, size_t a_retained_crc_offset, size_t a_field_offset, const void * a_p_new_value, size_t a_field_size);
+int ram_retained_seq_write(void * a_p_retained_var, size_t a_var_offset, const void * a_p_value, size_t a_var_size, size_t a_retained_crc_offset);
+int ram_retained_seq_read(const void * a_p_retained_var, size_t a_var_offset, void * a_p_value, size_t a_var_size);
+bool ram_retained_check_crc16(const void * a_retained_var_ptr, size_t a_retained_crc_offset);
+void ram_retained_update_crc16(void * a_p_retained_var, size_t a_retained_crc_offset);
+bool ram_retained_check_fletcher32(const void * a_retained_var_ptr, size_t a_retained_crc_offset);
+void ram_retained_update_fletcher32(void * a_p_retained_var, size_t a_retained_crc_offset);
+bool ram_retained_check_inverted(const void * a_retained_var_ptr, size_t a_retained_crc_offset);
+void ram_retained_update_inverted(void * a_p_retained_var, size_t a_retained_crc_offset);
+void ram_retained_update_ecc(void * a_p_retained_var, size_t a_retained_crc_offset);
+int ram_retained_recover_ecc(void * a_p_retained_var, size_t a_retained_crc_offset);
+int ram_retained_ab_write(void * a_p_retained_var, size_t a_var_offset, const void * a_p_value, size_t a_var_size, size_t a_slot_size);
+void ram_retained_ab_read(const void * a_p_retained_var, size_t a_var_offset, void * a_p_value, size_t a_var_size, size_t a_slot_size);
+bool ram_retained_check_ab(const void * a_retained_var_ptr, size_t a_retained_crc_offset);
+bool ram_retained_recover_ab(void * a_retained_var_ptr, size_t a_retained_crc_offset);
+int ram_retained_ab_read_checked(const void * a_p_retained_var, size_t a_var_offset, void * a_p_value, size_t a_var_size, size_t a_slot_size, uint32_t * a_p_seq);
+void ram_retained_bitset_set(void * a_p_retained_var, size_t a_configured_offset, size_t a_retained_crc_offset, size_t a_bit, bool a_value);
+void ram_retained_bitset_unset(void * a_p_retained_var, size_t a_configured_offset, size_t a_retained_crc_offset, size_t a_bit);
+typedef void (*ram_retained_ring_cb_t)(uint32_t a_seq, const void * a_p_entry, void * a_user_data);
+uint32_t ram_retained_ring_append(void * a_p_retained_var, size_t a_entry_offset, const void * a_p_entry, size_t a_entry_size, size_t a_stride, size_t a_capacity);
+size_t ram_retained_ring_foreach(const void * a_p_retained_var, size_t a_entry_offset, size_t a_stride, size_t a_capacity, ram_retained_ring_cb_t a_cb, void * a_user_data);
+bool ram_retained_recover_ring(void * a_retained_var_ptr, size_t a_retained_var_size, size_t a_stride);
+bool ram_retained_validate_integrity(enum ramRetIntegrity a_integrity, void * a_var_ptr, size_t a_var_size, size_t a_retained_crc_offset);
 int ram_range_retain(const void *ptr, size_t len, bool enable); // doesn't need to be used by the user, only used for testing purposes
+int ram_ranges_retain(const struct ramRetRange *ranges, size_t count, bool enable);
+int ram_retain_masks_add(uint32_t masks[RR_RAM_BLOCK_COUNT], const void *ptr, size_t len);
+void ram_retain_masks_apply(const uint32_t masks[RR_RAM_BLOCK_COUNT], bool enable);
+
+
+/**
+ * @brief Update the crc of every registered ram retention variable that is marked dirty with RR_Var_Ram_Ret_Defer().
+ * @note  Called automatically when CONFIG_APP_RETENTION_DEFERRED_COMMIT is enabled, can also be called by the user any time.
+*/
+void ram_retained_flush(void);
+void *ram_retained_access(const struct ramRetDescriptor *a_desc);
+
+/**
+ * @brief Id of a registered variable, 32-bit hash of its name. Used by the flash spill and the dump of the registry.
+ * @param [in] a_desc descriptor of the variable
+*/
+uint32_t ram_retained_desc_id(const struct ramRetDescriptor *a_desc);
+
+/**
+ * @brief Cycle counts of a registered ram retention variable.
+ * @param [in] a_desc descriptor of the variable, i.e. &_rr_desc_g_cnt or see RR_Var_Stats()
+ * @return statistics, NULL if CONFIG_APP_RETENTION_STATS isn't enabled.
+*/
+const struct ramRetStats *ram_retained_stats(const struct ramRetDescriptor *a_desc);
+
+/**
+ * @brief Cycle counts of the boot time validation pass, NULL if CONFIG_APP_RETENTION_STATS isn't enabled.
+*/
+const struct ramRetBootStats *ram_retained_boot_stats(void);
+
+/**
+ * @brief Cycle counts of a variable defined with RR_Init_Var_Ram_Retention(), see ram_retained_stats().
+*/
+#define RR_Var_Stats(rr_var_name) ram_retained_stats(&_rr_desc_##rr_var_name)
+
+/**
+ * @brief Number of variables checked with RR_INTEGRITY_ECC that were repaired instead of reset since boot, registered or not.
+*/
+uint32_t ram_retained_ecc_repairs(void);
+
+/**
+ * @brief Reset reason of the current boot, as read at the start of the ram retention init pass (or at the first call).
+ * @note  Value depends on the backend (CONFIG_APP_RETENTION_BACKEND), it isn't cleared by the library:
+ *        - POWER and the emulated POWER peripheral: POWER->RESETREAS, NRF_POWER_RESETREAS_*_MASK bits of hal/nrf_power.h.
+ *        - VMC and MEMCONF: RESET->RESETREAS, NRF_RESET_RESETREAS_*_MASK bits of hal/nrf_reset.h.
+ *        - no retention control: hwinfo_get_reset_cause(), RESET_* bits of zephyr/drivers/hwinfo.h.
+ * @return reset reason of the backend, 0 after a power-on or brown-out reset on every backend.
+*/
+uint32_t ram_retention_reset_reason(void);
+
+/**
+ * @brief true if the current boot is a power-on or brown-out reset, so retained RAM didn't hold any data.
+*/
+bool ram_retention_is_cold_boot(void);
+
+/**
+ * @brief Retain a set of ram retention variables given by their descriptors, in one pass and in a single IRQ lock window.
+ * @note  RR_Var_Ram_Ret_Many() can be used for variables defined with RR_Init_Var_Ram_Retention().
+ * @param [in] a_descs 	array of pointers to the descriptors
+ * @param [in] a_count 	number of elements in a_descs
+*/
+void ram_retained_update_many(const struct ramRetDescriptor *const a_descs[], size_t a_count);
+
+/**
+ * @brief Same as ram_retained_update_many() for an array of descriptors, i.e. descriptors that are created at runtime for variables that aren't registered.
+ * @note  state of a descriptor created at runtime can be NULL.
+ * @param [in] a_descs 	array of descriptors
+ * @param [in] a_count 	number of elements in a_descs
+*/
+void ram_retained_update_descs(const struct ramRetDescriptor a_descs[], size_t a_count);
 
 
 /**
@@ -582,7 +1499,77 @@ inline void RR_Var_Ram_Retain(void * a_p_retained_var, size_t a_retained_crc_off
 }
 
 /**
- * @deprecated Don't need to be used since workaround exist and explained.
+ * @brief Check the retained variable with the given integrity check algorithm without modifying it.
+ * @note  Inlined, when a_integrity is a compile time constant only the routine of that algorithm remains.
+ * @param [in] a_integrity 		integrity check algorithm of the ram retention type.
+ * @param [in] a_retained_var_ptr 	pointer to the ram retained variable
+ * @param [in] a_retained_crc_offset 	ram retention type variable's crc offset.
+ * @return true if valid, false if not.
+*/
+static ALWAYS_INLINE bool ram_retained_check_integrity(enum ramRetIntegrity a_integrity, const void * a_retained_var_ptr, size_t a_retained_crc_offset)
+{
+	switch (a_integrity) {
+	case RR_INTEGRITY_CRC16:
+		return ram_retained_check_crc16(a_retained_var_ptr, a_retained_crc_offset);
+	case RR_INTEGRITY_FLETCHER32:
+		return ram_retained_check_fletcher32(a_retained_var_ptr, a_retained_crc_offset);
+	case RR_INTEGRITY_NONE:
+		return true;
+	case RR_INTEGRITY_INVERTED:
+		return ram_retained_check_inverted(a_retained_var_ptr, a_retained_crc_offset);
+	case RR_INTEGRITY_AB:
+		return ram_retained_check_ab(a_retained_var_ptr, a_retained_crc_offset);
+	case RR_INTEGRITY_RING:
+		/* entries are checked one by one when they are read */
+		return true;
+	case RR_INTEGRITY_ECC:
+		/* parity word is only read by the repair */
+		return ram_retained_check(a_retained_var_ptr, a_retained_crc_offset + sizeof(uint32_t));
+	case RR_INTEGRITY_CRC32:
+	default:
+		return ram_retained_check(a_retained_var_ptr, a_retained_crc_offset + sizeof(uint32_t));
+	}
+}
+
+/**
+ * @brief Update the crc variable of the retained variable with the given integrity check algorithm.
+ * @note  Inlined, when a_integrity is a compile time constant only the routine of that algorithm remains.
+ * @param [in] a_integrity 		integrity check algorithm of the ram retention type.
+ * @param [in] a_p_retained_var 	pointer to the ram retained variable
+ * @param [in] a_retained_crc_offset 	ram retention type variable's crc offset.
+*/
+static ALWAYS_INLINE void ram_retained_update_integrity(enum ramRetIntegrity a_integrity, void * a_p_retained_var, size_t a_retained_crc_offset)
+{
+	switch (a_integrity) {
+	case RR_INTEGRITY_CRC16:
+		ram_retained_update_crc16(a_p_retained_var, a_retained_crc_offset);
+		break;
+	case RR_INTEGRITY_FLETCHER32:
+		ram_retained_update_fletcher32(a_p_retained_var, a_retained_crc_offset);
+		break;
+	case RR_INTEGRITY_NONE:
+		break;
+	case RR_INTEGRITY_INVERTED:
+		ram_retained_update_inverted(a_p_retained_var, a_retained_crc_offset);
+		break;
+	case RR_INTEGRITY_AB:
+		/* slots are committed by RR_AB_Write() */
+		break;
+	case RR_INTEGRITY_RING:
+		/* entries are committed by RR_Ring_Append() */
+		break;
+	case RR_INTEGRITY_ECC:
+		ram_retained_update_ecc(a_p_retained_var, a_retained_crc_offset);
+		break;
+	case RR_INTEGRITY_CRC32:
+	default:
+		ram_retained_update(a_p_retained_var, a_retained_crc_offset);
+		break;
+	}
+}
+
+/**
+ * @deprecated Don't need to be used since workaround exist and explained. For many boolean settings use RamRetTypeDeclareBitset() and RR_Bitset_Get().
  * @brief Boolean conditions to be used when ram retention on boolean variables are used and configured. 
  * @problem: A ram ret variable is always 0 at first start (which corresponds to false if variable holds boolean variable). Then when variable need to be initialized to some other value by default (i.e. 8) you need to set this value at every initialization. But you might also want to set the variable to some other value other than its initialization value. So the solution is that at the initialization, you check if the value is equal or smaller than the initialization value, if it is, you initialize the value to default, if not, you know that it's set a different value than default and leave it as it is. So for the boolean values case, you can implement this workaround. Check the note.
  * @note You can completely avoid using this enum. This can be avoided by the init value 0 (logical false) respresenting the default value you want to set on variable so that initialization of variable won't be necessary. For example, if ram ret variable <is_enabled>'s default value should be 1 (true) instead of using this workaround, you can rename the variable to <is_disabled> (and also inverse the logic in the program) so that the first initialization and default value is 0 (false).Variable can be configured to true later while retaining this value without any problem. 
@@ -0,0 +1,262 @@
+/**
+ * @author Batto1
+ * @brief  C++17 typed wrapper of ram retention variables, see ram_retention_utils.h.
+ *         RetainedVar<T, Integrity> has the same layout as a type declared with RamRetTypeDeclareIntegrity(T, ..., integrity), its crc offset and
+ *         size are compile time constants, so the type doesn't have to be repeated at every commit and every routine is specialized per type.
+ *         Changes are made through a modify() guard that commits once when it goes out of scope.
+ * @note   Needs CONFIG_CPP=y and CONFIG_STD_CPP17=y (or newer).
+ * @example
+ *	struct Settings { uint32_t boots; uint8_t mode; };
+ *	RR_Init_Retained_Var(g_settings, ram_retention::RetainedVar<Settings>);
+ *
+ *	g_settings.set(&Settings::boots, g_settings->boots + 1);	// incremental CRC update of a single member
+ *	{
+ *		auto settings = g_settings.modify();
+ *		settings->boots = 0;
+ *		settings->mode = 2;
+ *	}								// one commit here
+ */
+
+#ifndef RAM_RETENTION_UTILS_HPP
+#define RAM_RETENTION_UTILS_HPP
+
+#ifndef __cplusplus
+#error "ram_retention_utils.hpp is a C++ header, include ram_retention_utils.h from C"
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "ram_retention_utils.h"
+
+
+namespace ram_retention {
+
+/**
+ * @brief Integrity check algorithms of RetainedVar, same values as enum ramRetIntegrity.
+ * @note  INVERTED, AB and RING types have their own access routines and aren't wrapped.
+*/
+enum class Integrity : uint8_t {
+	Crc32		= RR_INTEGRITY_CRC32,
+	Crc16		= RR_INTEGRITY_CRC16,
+	Fletcher32	= RR_INTEGRITY_FLETCHER32,
+	None		= RR_INTEGRITY_NONE,
+	Ecc		= RR_INTEGRITY_ECC,
+};
+
+namespace detail {
+
+/* crc variable of each integrity check algorithm, see _RR_INTEGRITY_FIELD_* */
+template <Integrity I> struct IntegrityField;
+template <> struct IntegrityField<Integrity::Crc32>		{ using type = uint32_t; };
+template <> struct IntegrityField<Integrity::Crc16>		{ using type = uint16_t; };
+template <> struct IntegrityField<Integrity::Fletcher32>	{ using type = uint32_t; };
+
+/* Same layout as the struct of RamRetTypeDeclareIntegrity() */
+template <typename T, Integrity I>
+struct Storage {
+	T					rr_var;
+	typename IntegrityField<I>::type	crc;
+};
+
+template <typename T>
+struct Storage<T, Integrity::None> {
+	T		rr_var;
+	uint8_t		crc[0];
+};
+
+template <typename T>
+struct Storage<T, Integrity::Ecc> {
+	T		rr_var;
+	uint32_t	crc;
+	uint32_t	rr_parity;
+};
+
+/* Keeps the type of a member pointer from being deduced from the value too */
+template <typename U> struct NonDeduced { using type = U; };
+
+} // namespace detail
+
+
+/**
+ * @brief Ram retention variable of type T checked with integrity check algorithm I.
+ * @note  Has no constructor, so that nothing is written to it at startup. It must be defined with RR_Init_Retained_Var() or placed in
+ *        retained RAM and validated with validate() before it is used.
+ * @note  rr_var and crc are public so that it also works with the C macros taking a variable name, i.e. RR_Var_Access().
+*/
+template <typename T, Integrity I = Integrity::Crc32>
+class RetainedVar : public detail::Storage<T, I> {
+	static_assert(std::is_trivially_copyable_v<T>, "ram retained type must be trivially copyable, it is copied and checked byte by byte");
+
+	using storage_type = detail::Storage<T, I>;
+
+public:
+	using value_type = T;
+
+	static constexpr enum ramRetIntegrity integrity	= static_cast<enum ramRetIntegrity>(I);
+	static constexpr size_t crc_offset		= offsetof(storage_type, crc);
+	static constexpr size_t crc_size		= sizeof(storage_type) - crc_offset;	// 0 for Integrity::None
+
+	class Modify;
+
+	/**
+	 * @brief Read access, the variable isn't committed.
+	*/
+	const T &get() const { return this->rr_var; }
+	const T &operator*() const { return this->rr_var; }
+	const T *operator->() const { return &this->rr_var; }
+
+	/**
+	 * @brief Guard for changing the variable, it is committed once when the guard goes out of scope.
+	 * @example  auto v = g_var.modify(); v->foo = 1; v->bar = 2;
+	*/
+	[[nodiscard]] Modify modify() { return Modify(*this); }
+
+	/**
+	 * @brief Set one member of rr_var and retain the variable. With Integrity::Crc32 the crc is patched from the old and the new value of
+	 *        the member (see RR_Var_Ram_Ret_Field()), otherwise the variable is committed as a whole.
+	 * @param [in] a_field member of T, i.e. &Settings::boots
+	 * @param [in] a_value new value of the member
+	*/
+	template <typename F, typename C = T>
+	void set(F C::*a_field, const typename detail::NonDeduced<F>::type &a_value)
+	{
+		static_assert(std::is_same_v<C, T>, "a_field must be a member of T");
+
+		if constexpr (I == Integrity::Crc32) {
+			const F new_value = a_value;
+
+			ram_retained_update_field(this, crc_offset, field_offset(a_field), &new_value, sizeof(new_value));
+		} else {
+			this->rr_var.*a_field = a_value;
+			commit();
+		}
+	}
+
+	/**
+	 * @brief Assign the whole value and retain the variable.
+	*/
+	void set(const T &a_value)
+	{
+		this->rr_var = a_value;
+		commit();
+	}
+
+	/**
+	 * @brief Update the crc variable after rr_var is changed, same as RR_Var_Ram_Ret().
+	*/
+	void commit() { ram_retained_update_integrity(integrity, this, crc_offset); }
+
+	/**
+	 * @brief true if rr_var matches its crc variable, the variable isn't modified.
+	*/
+	bool check() const { return ram_retained_check_integrity(integrity, this, crc_offset); }
+
+	/**
+	 * @brief Check the variable and reset it to zero if it isn't valid, same as ram_retained_validate_integrity().
+	 *        Only needed for variables that aren't defined with RR_Init_Retained_Var().
+	 * @return true if valid, false if not.
+	*/
+	bool validate() { return ram_retained_validate_integrity(integrity, this, sizeof(*this), crc_offset); }
+
+private:
+	template <typename F, typename C>
+	size_t field_offset(F C::*a_field) const
+	{
+		return (size_t)(reinterpret_cast<const uint8_t *>(&(this->rr_var.*a_field)) - reinterpret_cast<const uint8_t *>(this));
+	}
+};
+
+
+/**
+ * @brief Scoped write access to a RetainedVar, see RetainedVar::modify().
+ * @note  If the only change made through the guard is a single set() of a member, the crc is patched by set() and nothing is committed at
+ *        scope exit. Any other change (i.e. through operator->) is committed once, with the whole variable, when the guard is destroyed.
+ * @note  Not thread safe by itself, same as RR_Var_Ram_Ret(). Variable must not be changed by an ISR while a guard of it is alive.
+*/
+template <typename T, Integrity I>
+class RetainedVar<T, I>::Modify {
+public:
+	explicit Modify(RetainedVar &a_var) : m_var(a_var) {}
+
+	Modify(const Modify &) = delete;
+	Modify &operator=(const Modify &) = delete;
+
+	~Modify()
+	{
+		if (m_state == State::DIRTY) {
+			m_var.commit();
+		}
+	}
+
+	T &operator*() { m_state = State::DIRTY; return m_var.rr_var; }
+	T *operator->() { m_state = State::DIRTY; return &m_var.rr_var; }
+
+	/**
+	 * @brief Set one member, see RetainedVar::set(). Only the first set() of an otherwise unchanged guard takes the incremental path.
+	*/
+	template <typename F, typename C = T>
+	void set(F C::*a_field, const typename detail::NonDeduced<F>::type &a_value)
+	{
+		if (m_state == State::CLEAN) {
+			m_var.set(a_field, a_value);
+			m_state = State::COMMITTED;
+		} else {
+			m_var.rr_var.*a_field = a_value;
+			m_state = State::DIRTY;
+		}
+	}
+
+	/**
+	 * @brief Commit now instead of at scope exit, i.e. before a long operation while the guard is still alive.
+	*/
+	void commit()
+	{
+		m_var.commit();
+		m_state = State::COMMITTED;
+	}
+
+private:
+	enum class State : uint8_t {
+		CLEAN,			// nothing changed
+		COMMITTED,		// changed and committed already
+		DIRTY,			// changed, committed at scope exit
+	};
+
+	RetainedVar &	m_var;
+	State		m_state = State::CLEAN;
+};
+
+} // namespace ram_retention
+
+
+/**
+ * @brief Define a RetainedVar in the ".ram_retained" linker section and register it for the boot time validation pass,
+ *        same as RR_Init_Var_Ram_Retention() without a default value.
+ * @note  Type is given last so that it can contain commas. Can be declared in another file with RR_Extern_Var_Ram_Retention() through
+ *        an alias of the type, i.e. using SettingsVar = ram_retention::RetainedVar<Settings>;
+ * @param [in] rr_var_name given name for the variable
+ * @param [in] ...         RetainedVar type, i.e. ram_retention::RetainedVar<Settings, ram_retention::Integrity::Crc16>
+*/
+#define RR_Init_Retained_Var(rr_var_name, ...)							\
+			static_assert(std::is_trivially_default_constructible_v<__VA_ARGS__>,	\
+				      "ram retained variable mustn't have a constructor");		\
+			_RR_RETAINED_SECTION(rr_var_name) __VA_ARGS__ rr_var_name;		\
+			atomic_t rr_var_name##_rr_state;					\
+			_RR_STATS_DEFINE(rr_var_name)						\
+			extern const struct ramRetDescriptor _rr_desc_##rr_var_name;		\
+			const STRUCT_SECTION_ITERABLE(ramRetDescriptor, _rr_desc_##rr_var_name) = {	\
+				.addr		= &rr_var_name,					\
+				.size		= sizeof(__VA_ARGS__),				\
+				.crc_offset	= __VA_ARGS__::crc_offset,			\
+				.name		= #rr_var_name,					\
+				.state		= &rr_var_name##_rr_state,			\
+				.defaults	= NULL,						\
+				.lazy		= false,					\
+				.layout		= 0,						\
+				_RR_STATS_INIT(rr_var_name)					\
+				.integrity	= __VA_ARGS__::integrity,			\
+			}
+
+#endif /* RAM_RETENTION_UTILS_HPP */
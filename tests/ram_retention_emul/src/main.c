@@ -0,0 +1,151 @@
+/**
+ * @author Batto1
+ * @brief  Ram retention on the emulated nRF52 POWER peripheral (CONFIG_APP_RETENTION_BACKEND_POWER_EMUL).
+ *         Every test emulates a reset with ram_retention_emul_reset(), checks which variables keep their value and which ones are
+ *         scrambled and reset to their default value, and the number of RAM[n].POWERSET/POWERCLR writes of the boot pass.
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+
+#include "ram_retention_utils.h"
+#include "ram_retention_power_emul.h"
+
+
+/* Bounds of the ".ram_retained" linker section, see ram_retention_noinit.ld */
+extern char __ram_retained_start[];
+extern char __ram_retained_end[];
+
+/* Larger than two RAM sections, so that it has a section of its own whatever the link order is */
+#define TEST_LOG_SIZE (2 * 4096)
+
+typedef struct testLog{
+	uint8_t	b[TEST_LOG_SIZE];
+}TestLog;
+
+RamRetTypeDeclare(TestLog, RamRetTestLog);
+
+RR_Init_Var_Ram_Retention(RamRetInt, g_kept, 7);
+RR_Init_Var_Ram_Retention(RamRetTestLog, g_log);
+
+#define TEST_VALUE 42
+
+
+
+/* Retention masks of an address range */
+static void test_masks(uint32_t a_masks[RR_RAM_BLOCK_COUNT], const void *a_ptr, size_t a_len)
+{
+	memset(a_masks, 0, RR_RAM_BLOCK_COUNT * sizeof(uint32_t));
+	zassert_ok(ram_retain_masks_add(a_masks, a_ptr, a_len), "range isn't in the emulated SRAM");
+}
+
+/* Boot pass sets the retention of the whole section with one POWERSET write per RAM block it covers, nothing else. */
+static uint32_t test_pass_writes(void)
+{
+	uint32_t masks[RR_RAM_BLOCK_COUNT];
+	uint32_t writes = 0;
+
+	test_masks(masks, __ram_retained_start, __ram_retained_end - __ram_retained_start);
+	for (size_t block = 0; block < RR_RAM_BLOCK_COUNT; block++) {
+		writes += (masks[block] != 0U) ? 1U : 0U;
+	}
+
+	return writes;
+}
+
+static void test_check_retained_section(void)
+{
+	uint32_t masks[RR_RAM_BLOCK_COUNT];
+
+	test_masks(masks, __ram_retained_start, __ram_retained_end - __ram_retained_start);
+	for (uint8_t block = 0; block < RR_RAM_BLOCK_COUNT; block++) {
+		zassert_equal(ram_retention_emul_ram_power(block) & masks[block], masks[block],
+			      "section of block %u isn't retained", block);
+	}
+}
+
+static bool test_log_is(uint8_t a_value)
+{
+	for (size_t i = 0; i < TEST_LOG_SIZE; i++) {
+		if (g_log.rr_var.b[i] != a_value) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void test_commit(void)
+{
+	g_kept.rr_var = TEST_VALUE;
+	RR_Var_Ram_Ret(RamRetInt, &g_kept);
+
+	memset(g_log.rr_var.b, 0xA5, TEST_LOG_SIZE);
+	RR_Var_Ram_Ret(RamRetTestLog, &g_log);
+}
+
+static void ram_retention_emul_before(void *fixture)
+{
+	ARG_UNUSED(fixture);
+
+	ram_retention_emul_reset(RR_EMUL_RESETREAS_POWER_ON);
+	test_commit();
+}
+
+
+
+ZTEST(ram_retention_emul, test_power_on_reset)
+{
+	ram_retention_emul_reset(RR_EMUL_RESETREAS_POWER_ON);
+
+	zassert_equal(g_kept.rr_var, 7, "variable isn't reset to its default value");
+	zassert_true(test_log_is(0), "variable isn't reset to 0");
+	zassert_equal(ram_retention_emul_writes(), test_pass_writes(), "unexpected register writes of the boot pass");
+	/* Section starts in block 0 and is longer than it, so it ends in block 1. */
+	zassert_equal(ram_retention_emul_writes(), 2, "section doesn't cover two RAM blocks");
+	test_check_retained_section();
+}
+
+ZTEST(ram_retention_emul, test_soft_reset)
+{
+	ram_retention_emul_reset(RR_EMUL_RESETREAS_SOFT);
+
+	zassert_equal(g_kept.rr_var, TEST_VALUE, "variable isn't kept");
+	zassert_true(test_log_is(0xA5), "variable isn't kept");
+	zassert_equal(ram_retention_emul_writes(), test_pass_writes(), "unexpected register writes of the boot pass");
+	test_check_retained_section();
+}
+
+ZTEST(ram_retention_emul, test_system_off_wakeup)
+{
+	ram_retention_emul_reset(RR_EMUL_RESETREAS_OFF);
+
+	zassert_equal(g_kept.rr_var, TEST_VALUE, "variable isn't kept");
+	zassert_true(test_log_is(0xA5), "variable isn't kept");
+	zassert_equal(ram_retention_emul_writes(), test_pass_writes(), "unexpected register writes of the boot pass");
+	test_check_retained_section();
+}
+
+ZTEST(ram_retention_emul, test_system_off_wakeup_unretained)
+{
+	uint32_t kept[RR_RAM_BLOCK_COUNT];
+	uint32_t log[RR_RAM_BLOCK_COUNT];
+
+	/* Sections of g_log that don't hold g_kept lose their retention. */
+	test_masks(kept, &g_kept, sizeof(g_kept));
+	test_masks(log, &g_log, sizeof(g_log));
+	for (size_t block = 0; block < RR_RAM_BLOCK_COUNT; block++) {
+		log[block] &= ~kept[block];
+	}
+	ram_retain_masks_apply(log, false);
+
+	ram_retention_emul_reset(RR_EMUL_RESETREAS_OFF);
+
+	zassert_equal(g_kept.rr_var, TEST_VALUE, "variable in a retained section isn't kept");
+	zassert_true(test_log_is(0), "scrambled variable isn't reset to 0");
+	zassert_equal(ram_retention_emul_writes(), test_pass_writes(), "unexpected register writes of the boot pass");
+	test_check_retained_section();
+}
+
+ZTEST_SUITE(ram_retention_emul, NULL, NULL, ram_retention_emul_before, NULL, NULL);